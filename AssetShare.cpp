@@ -0,0 +1,219 @@
+// Linux only: checks what a shared asset pack saves when many instances
+// run side by side, like the sessions of a terminal server. Builds a pack
+// in the shared_assets layout for a config, then starts N processes that
+// either map it read-only or hold their own copy of the same images (a
+// session that draws its own), and prints each one's private bytes the way
+// 'scrollctl metrics' counts them (resident pages not backed by a file).
+//   assetshare [--instances n] [--config config.ini] [--dir directory]
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "ScrollEngine.h"
+
+#define MAX_INSTANCES 256
+
+// --- Pack ---
+// Same entries BuildAssetPack writes for the common scaling steps. The
+// pixels are a fixed pattern rather than GDI+ output, which only the
+// Windows build has; the memory they take is the same.
+unsigned char* BuildPack(unsigned long long source, unsigned int* size)
+{
+    static const int dpis[] = {96, 120, 144, 168, 192};
+    AssetHeader h;
+    memset(&h, 0, sizeof(h));
+    h.magic = ASSET_MAGIC;
+    h.version = ASSET_VERSION;
+    h.source = source;
+    unsigned int used = sizeof(AssetHeader);
+    for (int i = 0; i < 5; i++)
+    {
+        int w = IndicatorExtent(dpis[i] / 96.0f);
+        AssetEntry* e = &h.indicators[h.indicator_count++];
+        e->offset = (used + ASSET_ALIGN - 1) & ~(ASSET_ALIGN - 1);
+        e->size = (unsigned int)w * w * 4;
+        e->width = e->height = w;
+        e->dpi = dpis[i];
+        used = e->offset + e->size;
+    }
+    h.size = used;
+
+    unsigned char* data = (unsigned char*)calloc(1, used);
+    if (!data) return NULL;
+    memcpy(data, &h, sizeof(h));
+    for (unsigned int i = sizeof(h); i < used; i++)
+        data[i] = (unsigned char)(i * 2654435761u >> 24);
+    *size = used;
+    return data;
+}
+
+// --- Instances ---
+// Resident pages not backed by a file, as LinuxAutoScroll reports them
+unsigned long long PrivateBytes()
+{
+    long pages = 0, resident = 0, shared = 0;
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (!statm) return 0;
+    if (fscanf(statm, "%ld %ld %ld", &pages, &resident, &shared) != 3)
+        resident = shared = 0;
+    fclose(statm);
+    return (unsigned long long)(resident - shared) * sysconf(_SC_PAGESIZE);
+}
+
+typedef struct
+{
+    int ok;
+    unsigned long long before, after; // private bytes
+} InstanceReport;
+
+// Child process: gets the images the way a session would, reads every
+// page of them like drawing does, reports and waits until all have
+void RunInstance(bool mapped, const char* path, const unsigned char* pack,
+                 unsigned int size, unsigned long long source, int report,
+                 int release)
+{
+    InstanceReport r = {0, PrivateBytes(), 0};
+    const unsigned char* data = NULL;
+    if (mapped)
+    {
+        int fd = open(path, O_RDONLY);
+        void* view = fd >= 0 ? mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0)
+                             : MAP_FAILED;
+        if (fd >= 0) close(fd); // the mapping keeps it alive
+        if (view != MAP_FAILED) data = (const unsigned char*)view;
+    }
+    else
+    {
+        unsigned char* copy = (unsigned char*)malloc(size);
+        if (copy) memcpy(copy, pack, size);
+        data = copy;
+    }
+
+    const AssetHeader* h = data ? CheckAssetPack(data, size, source) : NULL;
+    volatile unsigned int sum = 0;
+    long page = sysconf(_SC_PAGESIZE);
+    for (unsigned int i = 0; h && i < size; i += page) sum += data[i];
+    r.ok = h != NULL;
+    r.after = PrivateBytes();
+    ssize_t written = write(report, &r, sizeof(r));
+    char c;
+    ssize_t released = read(release, &c, 1); // EOF once all have reported
+    (void)written;
+    (void)released;
+    _exit(0);
+}
+
+// Runs n instances at once; fills the average growth of private bytes
+bool RunInstances(bool mapped, int n, const char* path,
+                  const unsigned char* pack, unsigned int size,
+                  unsigned long long source, double* averageKb)
+{
+    int report[2], release[2];
+    if (pipe(report) != 0 || pipe(release) != 0) return false;
+    int started = 0;
+    for (; started < n; started++)
+    {
+        pid_t pid = fork();
+        if (pid < 0) break;
+        if (pid == 0)
+        {
+            close(report[0]);
+            close(release[1]);
+            RunInstance(mapped, path, pack, size, source, report[1],
+                        release[0]);
+        }
+    }
+    close(report[1]);
+    close(release[0]);
+
+    bool ok = started == n;
+    unsigned long long total = 0;
+    for (int i = 0; i < started; i++)
+    {
+        InstanceReport r;
+        if (read(report[0], &r, sizeof(r)) != sizeof(r))
+        {
+            ok = false;
+            break;
+        }
+        ok = ok && r.ok;
+        unsigned long long grown = r.after > r.before ? r.after - r.before : 0;
+        total += grown;
+        printf("%-7s instance %3d: private %8llu KB (+%llu KB)\n",
+               mapped ? "mapped" : "copied", i, r.after / 1024,
+               grown / 1024);
+    }
+    close(release[1]);
+    close(report[0]);
+    while (wait(NULL) > 0)
+    {
+    }
+    *averageKb = started ? total / 1024.0 / started : 0.0;
+    return ok;
+}
+
+// --- Entry Point ---
+int main(int argc, char** argv)
+{
+    int instances = 8;
+    const char* configPath = "config.ini";
+    const char* dir = ".";
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--instances") && i + 1 < argc)
+            instances = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--config") && i + 1 < argc)
+            configPath = argv[++i];
+        else if (!strcmp(argv[i], "--dir") && i + 1 < argc)
+            dir = argv[++i];
+        else
+        {
+            fprintf(stderr,
+                    "usage: %s [--instances n] [--config config.ini] "
+                    "[--dir directory]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (instances < 1) instances = 1;
+    if (instances > MAX_INSTANCES) instances = MAX_INSTANCES;
+
+    LoadConfig(configPath);
+    unsigned long long source = HashFile(configPath);
+    char name[64], path[4096];
+    AssetPackName(name, sizeof(name), source);
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    unsigned int size = 0;
+    unsigned char* pack = BuildPack(source, &size);
+    FILE* file = pack ? fopen(path, "wb") : NULL;
+    if (!file || fwrite(pack, size, 1, file) != 1)
+    {
+        fprintf(stderr, "cannot write %s\n", path);
+        return 2;
+    }
+    fclose(file);
+    printf("%s: %u KB\n", path, size / 1024);
+
+    double copiedKb = 0.0, mappedKb = 0.0;
+    bool ok = RunInstances(false, instances, path, pack, size, source,
+                           &copiedKb) &&
+              RunInstances(true, instances, path, pack, size, source,
+                           &mappedKb);
+    remove(path);
+    free(pack);
+    printf("average private growth: copied %.0f KB, mapped %.0f KB\n",
+           copiedKb, mappedKb);
+    if (!ok)
+    {
+        fprintf(stderr, "an instance could not map or validate the pack\n");
+        return 1;
+    }
+    // The pack is only worth having if mapping it costs a session less
+    // than half of drawing its own
+    return mappedKb * 2 < copiedKb ? 0 : 1;
+}
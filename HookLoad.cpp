@@ -0,0 +1,258 @@
+// Synthetic high polling rate load on the primed trigger: a press followed
+// by a slow drag, reported at 1 to 8 kHz like a gaming mouse, fed through
+// the hook's side of the drag threshold and a model of the event loop that
+// handles one message per service time. Compares the hook posting every
+// primed move (the old path, the loop then reads the cursor) with the
+// DragGate the Win32 hook uses, and prints the messages queued, how long
+// they wait and the hook time per move. The old path's hook time only
+// counts queueing into the model, PostMessage itself costs more.
+//   hookload [--seconds s] [--service-us n] [--threshold px]
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <vector>
+
+#include "ScrollEngine.h"
+
+#define DRAG_SPEED 10.0 // pixels per second: a careful start
+
+// --- Event Loop Model ---
+typedef enum
+{
+    LOAD_BUTTON_DOWN,
+    LOAD_BUTTON_UP,
+    LOAD_MOVE,      // old path: the loop reads the cursor itself
+    LOAD_DRAG_START // gated path: carries the move that crossed
+} LoadMessageType;
+
+typedef struct
+{
+    LoadMessageType type;
+    int x, y;
+    double posted;
+} LoadMessage;
+
+typedef struct
+{
+    std::vector<LoadMessage> queue;
+    size_t head;
+    double service, busyUntil;
+    int maxQueued;
+    double maxWait;
+    double started; // time the gesture started, < 0 before
+} EventLoop;
+
+// Pointer position of the synthetic drag at time t
+void PointerAt(double t, int* x, int* y)
+{
+    *x = (int)(t * 1000) % 2; // sensor noise on the other axis
+    *y = (int)(t * DRAG_SPEED);
+}
+
+void Post(EventLoop* l, LoadMessageType type, int x, int y, double now)
+{
+    LoadMessage m = {type, x, y, now};
+    l->queue.push_back(m);
+    int queued = (int)(l->queue.size() - l->head);
+    if (queued > l->maxQueued) l->maxQueued = queued;
+}
+
+// Handles every message it gets to by now, the way WndProc does
+void RunLoop(EventLoop* l, double now)
+{
+    while (l->head < l->queue.size())
+    {
+        const LoadMessage* m = &l->queue[l->head];
+        double begin = l->busyUntil > m->posted ? l->busyUntil : m->posted;
+        if (begin + l->service > now) break;
+        l->busyUntil = begin + l->service;
+        if (begin - m->posted > l->maxWait) l->maxWait = begin - m->posted;
+        l->head++;
+
+        int x = m->x, y = m->y;
+        TriggerAction a = ACTION_NONE;
+        switch (m->type)
+        {
+        case LOAD_BUTTON_DOWN:
+            a = OnTriggerButtonDown(0, x, y);
+            break;
+        case LOAD_BUTTON_UP:
+            a = OnTriggerButtonUp(0);
+            break;
+        case LOAD_MOVE:
+            PointerAt(begin, &x, &y); // GetCursorPos
+            // fall through
+        case LOAD_DRAG_START:
+            a = OnPrimedMove(x, y);
+            break;
+        }
+        if (a == ACTION_START && BeginScrolling(x, y))
+            l->started = begin;
+        if (a == ACTION_STOP && EndScrolling()) g_scrollState = STATE_IDLE;
+    }
+}
+
+// --- Hook ---
+typedef struct
+{
+    int posted, dragStarts;
+    double crossed; // first move past the threshold
+    double startMs, waitMs, hookNs;
+    int maxQueued;
+} LoadResult;
+
+DragGate g_gate;
+
+// Cost of reading the clock twice, taken off every timed hook call
+double ClockOverheadNs()
+{
+    const int rounds = 100000;
+    std::chrono::steady_clock::time_point begin =
+        std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++)
+    {
+        volatile long long t =
+            std::chrono::steady_clock::now().time_since_epoch().count();
+        (void)t;
+    }
+    return std::chrono::duration<double, std::nano>(
+               std::chrono::steady_clock::now() - begin)
+               .count() /
+           rounds;
+}
+
+void RunLoad(int hz, bool gated, double seconds, double service,
+             int threshold, double clockNs, LoadResult* r)
+{
+    EventLoop l;
+    l.head = 0;
+    l.service = service;
+    l.busyUntil = 0.0;
+    l.maxQueued = 0;
+    l.maxWait = 0.0;
+    l.started = -1.0;
+    l.queue.reserve((size_t)(hz * seconds) + 2);
+    memset(r, 0, sizeof(*r));
+    r->crossed = -1.0;
+    g_scrollState = STATE_IDLE;
+
+    // The press: both paths post it, the gate is armed with its point
+    Post(&l, LOAD_BUTTON_DOWN, 0, 0, 0.0);
+    if (gated) ArmDragGate(&g_gate, 0, 0, threshold);
+
+    int moves = (int)(hz * seconds);
+    double hookNs = 0.0;
+    for (int i = 1; i <= moves; i++)
+    {
+        double now = (double)i / hz;
+        RunLoop(&l, now);
+        int x, y;
+        PointerAt(now, &x, &y);
+        if (r->crossed < 0.0 && PastDragThreshold(x, y, 0, 0, threshold))
+            r->crossed = now;
+
+        std::chrono::steady_clock::time_point begin =
+            std::chrono::steady_clock::now();
+        if (gated)
+        {
+            if (CrossDragGate(&g_gate, x, y))
+            {
+                Post(&l, LOAD_DRAG_START, x, y, now);
+                r->dragStarts++;
+            }
+        }
+        else if (g_scrollState == STATE_PRIMED)
+        {
+            Post(&l, LOAD_MOVE, 0, 0, now);
+        }
+        hookNs += std::chrono::duration<double, std::nano>(
+                      std::chrono::steady_clock::now() - begin)
+                      .count();
+    }
+
+    double release = (double)(moves + 1) / hz;
+    if (gated) DisarmDragGate(&g_gate);
+    Post(&l, LOAD_BUTTON_UP, 0, 0, release);
+    RunLoop(&l, HUGE_VAL); // drain
+    if (g_scrollState == STATE_SCROLLING) EndScrolling();
+    g_scrollState = STATE_IDLE;
+
+    r->posted = (int)l.queue.size();
+    r->maxQueued = l.maxQueued;
+    r->waitMs = l.maxWait * 1000;
+    r->startMs = l.started >= 0.0 && r->crossed >= 0.0
+                     ? (l.started - r->crossed) * 1000
+                     : -1.0;
+    r->hookNs = moves ? hookNs / moves - clockNs : 0.0;
+    if (r->hookNs < 0.0) r->hookNs = 0.0;
+}
+
+// --- Entry Point ---
+int main(int argc, char** argv)
+{
+    double seconds = 1.0;
+    double serviceUs = 200.0; // WndProc on a main thread that also draws
+    int threshold = 4;        // the Windows default drag rectangle
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--seconds") && i + 1 < argc)
+            seconds = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--service-us") && i + 1 < argc)
+            serviceUs = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--threshold") && i + 1 < argc)
+            threshold = atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr,
+                    "usage: %s [--seconds s] [--service-us n] "
+                    "[--threshold px]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (threshold < 0) threshold = 0;
+    if (seconds * DRAG_SPEED <= threshold + 1)
+        seconds = (threshold + 2) / DRAG_SPEED; // the drag has to cross
+    g_config.trace_file[0] = 0;
+    g_config.drag_threshold = threshold;
+    g_config.dpi_scaling = 0;
+    CompileTriggerTable(&g_triggers);
+    MotionProfile m;
+    ScaleMotionProfile(&m, 96);
+    SelectMotionProfile(&m);
+
+    double clockNs = ClockOverheadNs();
+    printf("%.1f s drag at %.0f px/s, threshold %d px, %.0f us per message\n",
+           seconds, DRAG_SPEED, threshold, serviceUs);
+    printf("%-6s %-6s %7s %10s %11s %9s %12s\n", "rate", "hook", "posted",
+           "max_queued", "max_wait_ms", "start_ms", "hook_ns/move");
+    static const int rates[] = {1000, 4000, 8000};
+    bool ok = true;
+    for (int i = 0; i < 3; i++)
+    {
+        for (int gated = 0; gated < 2; gated++)
+        {
+            LoadResult r;
+            RunLoad(rates[i], gated != 0, seconds, serviceUs / 1e6, threshold,
+                    clockNs, &r);
+            printf("%4dHz %-6s %7d %10d %11.1f %9.2f %12.1f\n", rates[i],
+                   gated ? "gated" : "every", r.posted, r.maxQueued,
+                   r.waitMs, r.startMs, r.hookNs);
+            if (!gated) continue;
+            // Press, one crossing, release; the gesture starts as soon as
+            // the loop gets to the crossing
+            if (r.dragStarts != 1 || r.posted != 3 || r.startMs < 0.0 ||
+                r.startMs > serviceUs / 1000 + 1e-6)
+            {
+                fprintf(stderr, "%d Hz: gated hook posted %d crossings, "
+                                "gesture started after %.2f ms\n",
+                        rates[i], r.dragStarts, r.startMs);
+                ok = false;
+            }
+        }
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,760 @@
+// Linux backend: grabs one evdev mouse, re-emits its events through a uinput
+// clone and turns middle-drag into high-resolution wheel events.
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <linux/input.h>
+#include <linux/uinput.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "ScrollEngine.h"
+
+#ifndef REL_WHEEL_HI_RES
+#define REL_WHEEL_HI_RES 0x0b
+#define REL_HWHEEL_HI_RES 0x0c
+#endif
+
+// One legacy REL_WHEEL notch, same scale as Windows' WHEEL_DELTA
+#define HI_RES_PER_NOTCH 120
+#define MAX_FRAME_EVENTS 64
+
+// realtime_scheduling: low realtime priority (audio servers use 50+) and
+// the longest a scroll thread may run without blocking, in microseconds
+#define REALTIME_PRIORITY 10
+#define REALTIME_RUNTIME_US 200000
+
+// --- Global State ---
+int g_inputFd = -1, g_uinputFd = -1;
+std::atomic<int> g_pointerX(0), g_pointerY(0); // integrated relative motion
+int g_pointerMovedFd = -1; // eventfd: wakes a grab-pan sampler per report
+volatile sig_atomic_t g_running = 1;
+volatile sig_atomic_t g_dumpFlightTrace = 0; // set by SIGUSR1
+pthread_mutex_t g_uinputLock = PTHREAD_MUTEX_INITIALIZER;
+int g_notchRemainderV = 0, g_notchRemainderH = 0;
+char g_statsPath[4096], g_flightTracePath[4096];
+HeldButtons g_heldTriggers = {0, 0, 0}; // swallowed presses awaiting release
+const char* g_configPath = "config.ini";
+double g_startupMs = 0.0;
+std::atomic<bool> g_paused(false);
+std::atomic<int> g_realtime(0); // ControlMetrics.realtime
+std::atomic<unsigned int> g_gestureInputCalls(0); // uinput wheel writes
+volatile sig_atomic_t g_realtimeRevoked = 0; // set by SIGXCPU
+
+// --- Control Channel ---
+// Commands that change state are handed to the event loop, which the
+// control thread wakes with SIGUSR2.
+int g_controlFd = -1;
+char g_controlPath[sizeof(((struct sockaddr_un*)0)->sun_path)];
+pthread_t g_mainThread;
+std::atomic<int> g_controlCommand(0), g_controlStatus(0);
+
+// --- Prototypes ---
+void* ScrollingThread(void*);
+void* EmitterThread(void*);
+void EnterRealtime();
+void OnRealtimeOverrun(int sig);
+void StartScrolling();
+void StopScrolling();
+void ApplyTriggerAction(TriggerAction a);
+int TriggerButtonFromCode(int code);
+void WriteFrame(struct input_event* ev, int count);
+void LinuxGetPointer(int* x, int* y);
+void LinuxEmitScroll(int vS, int hS);
+void LinuxSetFeedback(ScrollCursorType t);
+double LinuxNow();
+void LinuxWait(int ms);
+void LinuxWaitInput(int ms);
+int OpenUinputClone();
+void LoadStats();
+void SaveStats();
+bool OpenControlSocket();
+void* ControlThread(void*);
+void HandleControlRequest(const ControlRequest* req, ControlReply* reply);
+void RunControlCommand();
+void FillControlMetrics(ControlMetrics* m);
+
+const ScrollBackend g_linuxBackend = {LinuxGetPointer, LinuxEmitScroll,
+                                      LinuxSetFeedback, LinuxNow,
+                                      LinuxWait,        LinuxWait,
+                                      LinuxWaitInput};
+
+void OnSignal(int sig)
+{
+    if (sig == SIGUSR1)
+        g_dumpFlightTrace = 1;
+    else if (sig != SIGUSR2) // SIGUSR2 only interrupts read()
+        g_running = 0;
+}
+
+// --- Entry Point ---
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr,
+                "usage: %s /dev/input/by-id/<mouse>-event-mouse [config.ini]\n",
+                argv[0]);
+        return 1;
+    }
+
+    ssize_t len = readlink("/proc/self/exe", g_statsPath,
+                           sizeof(g_statsPath) - sizeof("flight-trace.json"));
+    if (len < 0) len = 0;
+    g_statsPath[len] = 0;
+    char* lastSlash = strrchr(g_statsPath, '/');
+    if (lastSlash)
+        *(lastSlash + 1) = 0;
+    else
+        g_statsPath[0] = 0;
+    strcpy(g_flightTracePath, g_statsPath);
+    strcat(g_statsPath, "stats.ini");
+    strcat(g_flightTracePath, "flight-trace.json");
+
+    double launched = LinuxNow();
+    FlightNameThread("main");
+    g_mainThread = pthread_self();
+    if (!OpenControlSocket()) return 1;
+
+    if (argc > 2) g_configPath = argv[2];
+    LoadConfig(g_configPath);
+    OpenTrace(g_config.trace_file, LinuxNow);
+    LoadStats();
+
+    g_inputFd = open(argv[1], O_RDONLY);
+    if (g_inputFd < 0)
+    {
+        fprintf(stderr, "cannot open %s: %s\n", argv[1], strerror(errno));
+        return 1;
+    }
+    g_uinputFd = OpenUinputClone();
+    if (g_uinputFd < 0)
+    {
+        fprintf(stderr, "cannot create uinput device: %s\n", strerror(errno));
+        return 1;
+    }
+    // Exclusive grab: every event now reaches the desktop through our clone,
+    // which is what lets us swallow the trigger button.
+    if (ioctl(g_inputFd, EVIOCGRAB, 1) < 0)
+    {
+        fprintf(stderr, "cannot grab %s: %s\n", argv[1], strerror(errno));
+        return 1;
+    }
+    g_pointerMovedFd = eventfd(0, EFD_NONBLOCK);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = OnSignal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    sigaction(SIGUSR1, &sa, NULL);
+    sigaction(SIGUSR2, &sa, NULL);
+    // Only realtime scroll threads unblock SIGXCPU, so the one that
+    // overran its RLIMIT_RTTIME budget is the one that handles it
+    sa.sa_handler = OnRealtimeOverrun;
+    sigaction(SIGXCPU, &sa, NULL);
+    sigset_t xcpu;
+    sigemptyset(&xcpu);
+    sigaddset(&xcpu, SIGXCPU);
+    pthread_sigmask(SIG_BLOCK, &xcpu, NULL);
+
+    pthread_t control;
+    if (g_controlFd >= 0 &&
+        pthread_create(&control, NULL, ControlThread, NULL) == 0)
+        pthread_detach(control);
+    g_startupMs = (LinuxNow() - launched) * 1000.0;
+
+    struct input_event frame[MAX_FRAME_EVENTS];
+    int frameCount = 0;
+    bool frameMoved = false;
+    while (g_running)
+    {
+        struct input_event ev;
+        ssize_t n = read(g_inputFd, &ev, sizeof(ev));
+        if (g_dumpFlightTrace)
+        {
+            g_dumpFlightTrace = 0;
+            if (DumpFlightTrace(g_flightTracePath))
+                fprintf(stderr, "flight trace saved to %s\n",
+                        g_flightTracePath);
+        }
+        if (g_controlCommand.load()) RunControlCommand();
+        if (n != sizeof(ev))
+        {
+            if (n < 0 && errno == EINTR) continue;
+            break;
+        }
+
+        unsigned long long begin = FlightNow();
+        bool forward = true;
+        if (ev.type == EV_REL && (ev.code == REL_X || ev.code == REL_Y))
+        {
+            if (ev.code == REL_X)
+                g_pointerX += ev.value;
+            else
+                g_pointerY += ev.value;
+            frameMoved = true;
+            if (g_scrollState == STATE_PRIMED &&
+                PastDragThreshold(g_pointerX, g_pointerY, g_primeStartPos.x,
+                                  g_primeStartPos.y, g_motion.drag_threshold))
+                ApplyTriggerAction(OnPrimedMove(g_pointerX, g_pointerY));
+        }
+        else if (ev.type == EV_KEY && !g_paused &&
+                 (TriggerButtonFromCode(ev.code) & g_triggers.buttonMask))
+        {
+            // No keyboard access here, so chords never match on Linux
+            int button = TriggerButtonFromCode(ev.code);
+            int binding = FindButtonBinding(&g_triggers, button, 0);
+            if (ev.value == 1 && binding >= 0)
+            {
+                PressHeldButton(&g_heldTriggers, button, binding);
+                ApplyTriggerAction(
+                    OnTriggerButtonDown(binding, g_pointerX, g_pointerY));
+                forward = false;
+            }
+            else if (ev.value == 0 &&
+                     ReleaseHeldButton(&g_heldTriggers, button, &binding))
+            {
+                if (binding >= 0)
+                    ApplyTriggerAction(OnTriggerButtonUp(binding));
+                forward = false;
+            }
+        }
+        // Same rule as the Win32 hook: idle motion is not worth a record.
+        if (ev.type == EV_KEY || g_scrollState != STATE_IDLE)
+            FlightSpan(FLIGHT_HOOK_MOUSE, ev.code, begin);
+
+        if (ev.type == EV_SYN && ev.code == SYN_REPORT)
+        {
+            if (frameCount > 0) WriteFrame(frame, frameCount);
+            frameCount = 0;
+            // Once per report, so a diagonal move is sampled with both axes
+            if (frameMoved && g_pointerMovedFd >= 0 &&
+                g_scrollState == STATE_SCROLLING && IsPanGesture())
+            {
+                uint64_t one = 1;
+                ssize_t ignored = write(g_pointerMovedFd, &one, sizeof(one));
+                (void)ignored;
+            }
+            frameMoved = false;
+        }
+        else if (forward && frameCount < MAX_FRAME_EVENTS)
+        {
+            frame[frameCount++] = ev;
+        }
+    }
+
+    StopScrolling();
+    while (g_scrollState == STATE_STOPPING) LinuxWait(1);
+    SaveStats();
+    CloseTrace();
+    if (g_controlFd >= 0) unlink(g_controlPath);
+    ioctl(g_inputFd, EVIOCGRAB, 0);
+    ioctl(g_uinputFd, UI_DEV_DESTROY);
+    close(g_uinputFd);
+    close(g_inputFd);
+    if (g_pointerMovedFd >= 0) close(g_pointerMovedFd);
+    return 0;
+}
+
+// --- Logic ---
+void StartScrolling()
+{
+    if (!BeginScrolling(g_pointerX, g_pointerY)) return;
+    g_notchRemainderV = g_notchRemainderH = 0;
+    g_gestureInputCalls = 0;
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, ScrollingThread, NULL) == 0)
+        pthread_detach(thread);
+    else
+        g_scrollState = STATE_IDLE;
+}
+
+void StopScrolling()
+{
+    if (EndScrolling() && g_config.fun_stats) SaveStats();
+}
+
+void ApplyTriggerAction(TriggerAction a)
+{
+    switch (a)
+    {
+    case ACTION_START:
+        StartScrolling();
+        break;
+    case ACTION_STOP:
+        StopScrolling();
+        break;
+    case ACTION_CLICK:
+    {
+        static const int codes[] = {BTN_LEFT, BTN_RIGHT, BTN_MIDDLE, BTN_SIDE,
+                                    BTN_EXTRA};
+        int button = g_triggers.bindings[g_activeBinding].button;
+        int code = BTN_MIDDLE;
+        for (int i = 0; i < 5; i++)
+            if (button == 1 << i) code = codes[i];
+
+        struct input_event ev[2];
+        memset(ev, 0, sizeof(ev));
+        ev[0].type = ev[1].type = EV_KEY;
+        ev[0].code = ev[1].code = code;
+        ev[0].value = 1;
+        WriteFrame(&ev[0], 1);
+        ev[1].value = 0;
+        WriteFrame(&ev[1], 1);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+int TriggerButtonFromCode(int code)
+{
+    switch (code)
+    {
+    case BTN_LEFT:
+        return TRIGGER_BUTTON_LEFT;
+    case BTN_RIGHT:
+        return TRIGGER_BUTTON_RIGHT;
+    case BTN_MIDDLE:
+        return TRIGGER_BUTTON_MIDDLE;
+    case BTN_SIDE:
+        return TRIGGER_BUTTON_X1;
+    case BTN_EXTRA:
+        return TRIGGER_BUTTON_X2;
+    default:
+        return 0;
+    }
+}
+
+// --- Thread ---
+void* ScrollingThread(void* arg)
+{
+    EnterRealtime(); // before the emitter is created, which inherits it
+    // Decoupled mode: this thread only samples, EmitterThread emits.
+    pthread_t emitter;
+    bool decoupled = false;
+    PublishVelocity(0.0f, 0.0f);
+    if (g_config.output_frequency > 0 && !IsPanGesture())
+        decoupled = pthread_create(&emitter, NULL, EmitterThread, NULL) == 0;
+
+    RunSampler(&g_linuxBackend, decoupled);
+
+    if (decoupled) pthread_join(emitter, NULL);
+    FlightReleaseThread();
+    g_scrollState = STATE_IDLE;
+    return NULL;
+}
+
+void* EmitterThread(void* arg)
+{
+    EnterRealtime();
+    RunEmitter(&g_linuxBackend);
+    FlightReleaseThread();
+    return NULL;
+}
+
+// realtime_scheduling: moves the calling scroll thread to SCHED_RR so
+// background load cannot delay its ticks. Without CAP_SYS_NICE the
+// priority is lowered to what RLIMIT_RTPRIO allows (e.g. an audio group
+// limit), and without that it stays a normal thread. RLIMIT_RTTIME bounds
+// the damage of a thread that stops blocking: the kernel sends SIGXCPU
+// instead of letting it starve the desktop.
+void EnterRealtime()
+{
+    if (!g_config.realtime_scheduling)
+    {
+        g_realtime = 0;
+        return;
+    }
+    if (g_realtimeRevoked)
+    {
+        g_realtime = -1;
+        return;
+    }
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_RTTIME, &limit) == 0 &&
+        limit.rlim_cur > REALTIME_RUNTIME_US)
+    {
+        limit.rlim_cur = REALTIME_RUNTIME_US;
+        setrlimit(RLIMIT_RTTIME, &limit);
+    }
+
+    struct sched_param param;
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = REALTIME_PRIORITY;
+    int error = pthread_setschedparam(pthread_self(), SCHED_RR, &param);
+    if (error == EPERM && getrlimit(RLIMIT_RTPRIO, &limit) == 0 &&
+        limit.rlim_cur > 0 && limit.rlim_cur < REALTIME_PRIORITY)
+    {
+        param.sched_priority = (int)limit.rlim_cur;
+        error = pthread_setschedparam(pthread_self(), SCHED_RR, &param);
+    }
+
+    int core = g_config.realtime_core;
+    if (core >= 0 && core < CPU_SETSIZE)
+    {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(core, &cpus);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    }
+
+    if (!error)
+    {
+        sigset_t xcpu;
+        sigemptyset(&xcpu);
+        sigaddset(&xcpu, SIGXCPU);
+        pthread_sigmask(SIG_UNBLOCK, &xcpu, NULL);
+    }
+
+    // Warn once per fallback, not per gesture
+    if (g_realtime.exchange(error ? -1 : 1) != -1 && error)
+        fprintf(stderr, "realtime scheduling not available (%s), "
+                        "scrolling at normal priority\n",
+                strerror(error));
+}
+
+// SIGXCPU: a realtime scroll thread ran REALTIME_RUNTIME_US without
+// blocking. The default action would dump core; instead the thread drops
+// back to SCHED_OTHER and realtime stays off until the next start, since
+// whatever kept it busy will likely do so again.
+void OnRealtimeOverrun(int sig)
+{
+    struct sched_param param;
+    memset(&param, 0, sizeof(param));
+    sched_setscheduler(0, SCHED_OTHER, &param); // the calling thread only
+    g_realtimeRevoked = 1;
+    g_realtime = -1;
+    static const char message[] = "realtime scroll thread overran its "
+                                  "budget, scrolling at normal priority\n";
+    ssize_t ignored = write(STDERR_FILENO, message, sizeof(message) - 1);
+    (void)ignored;
+}
+
+// --- Linux Backend ---
+// Appends SYN_REPORT and writes the frame in one go, so wheel frames from
+// the scroll threads never interleave with forwarded device frames.
+void WriteFrame(struct input_event* ev, int count)
+{
+    struct input_event out[MAX_FRAME_EVENTS + 1];
+    memcpy(out, ev, count * sizeof(struct input_event));
+    memset(&out[count], 0, sizeof(struct input_event));
+    out[count].type = EV_SYN;
+    out[count].code = SYN_REPORT;
+
+    unsigned long long begin = FlightNow();
+    pthread_mutex_lock(&g_uinputLock);
+    ssize_t ignored = write(g_uinputFd, out, (count + 1) * sizeof(out[0]));
+    (void)ignored;
+    pthread_mutex_unlock(&g_uinputLock);
+    FlightSpan(FLIGHT_UINPUT_WRITE, count, begin);
+}
+
+void LinuxGetPointer(int* x, int* y)
+{
+    *x = g_pointerX;
+    *y = g_pointerY;
+}
+
+// vS/hS are already in 1/120 notch units, which is exactly the scale of
+// REL_WHEEL_HI_RES. Legacy REL_WHEEL notches are sent alongside for clients
+// that ignore the hi-res axis.
+void LinuxEmitScroll(int vS, int hS)
+{
+    if (vS == 0 && hS == 0) return;
+
+    struct input_event ev[4];
+    int count = 0;
+    memset(ev, 0, sizeof(ev));
+    if (vS != 0)
+    {
+        ev[count].type = EV_REL;
+        ev[count].code = REL_WHEEL_HI_RES;
+        ev[count++].value = vS;
+        g_notchRemainderV += vS;
+        int notches = g_notchRemainderV / HI_RES_PER_NOTCH;
+        if (notches != 0)
+        {
+            g_notchRemainderV -= notches * HI_RES_PER_NOTCH;
+            ev[count].type = EV_REL;
+            ev[count].code = REL_WHEEL;
+            ev[count++].value = notches;
+        }
+    }
+    if (hS != 0)
+    {
+        ev[count].type = EV_REL;
+        ev[count].code = REL_HWHEEL_HI_RES;
+        ev[count++].value = hS;
+        g_notchRemainderH += hS;
+        int notches = g_notchRemainderH / HI_RES_PER_NOTCH;
+        if (notches != 0)
+        {
+            g_notchRemainderH -= notches * HI_RES_PER_NOTCH;
+            ev[count].type = EV_REL;
+            ev[count].code = REL_HWHEEL;
+            ev[count++].value = notches;
+        }
+    }
+    WriteFrame(ev, count);
+    g_gestureInputCalls.fetch_add(1, std::memory_order_relaxed);
+    AccumulateStats(vS, hS);
+}
+
+// evdev has no cursor shapes; feedback is left to the compositor.
+void LinuxSetFeedback(ScrollCursorType t)
+{
+}
+
+double LinuxNow()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+void LinuxWait(int ms)
+{
+    struct timespec ts = {ms / 1000, (long)(ms % 1000) * 1000000L};
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+    {
+    }
+}
+
+// Returns early on the next motion report; reports that arrived meanwhile
+// are folded into one wake-up.
+void LinuxWaitInput(int ms)
+{
+    if (g_pointerMovedFd < 0)
+    {
+        LinuxWait(ms);
+        return;
+    }
+    struct pollfd p = {g_pointerMovedFd, POLLIN, 0};
+    if (poll(&p, 1, ms) > 0)
+    {
+        uint64_t count;
+        ssize_t ignored = read(g_pointerMovedFd, &count, sizeof(count));
+        (void)ignored;
+    }
+}
+
+int OpenUinputClone()
+{
+    int fd = open("/dev/uinput", O_WRONLY | O_NONBLOCK);
+    if (fd < 0) return -1;
+
+    ioctl(fd, UI_SET_EVBIT, EV_SYN);
+    ioctl(fd, UI_SET_EVBIT, EV_KEY);
+    for (int btn = BTN_LEFT; btn <= BTN_TASK; btn++)
+        ioctl(fd, UI_SET_KEYBIT, btn);
+    ioctl(fd, UI_SET_EVBIT, EV_REL);
+    ioctl(fd, UI_SET_RELBIT, REL_X);
+    ioctl(fd, UI_SET_RELBIT, REL_Y);
+    ioctl(fd, UI_SET_RELBIT, REL_WHEEL);
+    ioctl(fd, UI_SET_RELBIT, REL_HWHEEL);
+    ioctl(fd, UI_SET_RELBIT, REL_WHEEL_HI_RES);
+    ioctl(fd, UI_SET_RELBIT, REL_HWHEEL_HI_RES);
+
+    struct uinput_setup setup;
+    memset(&setup, 0, sizeof(setup));
+    setup.id.bustype = BUS_VIRTUAL;
+    strcpy(setup.name, "WinAutoScroll virtual mouse");
+    if (ioctl(fd, UI_DEV_SETUP, &setup) < 0 || ioctl(fd, UI_DEV_CREATE) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// --- Stats ---
+void LoadStats()
+{
+    ReadStatsFile(g_statsPath, &g_stats);
+}
+
+void SaveStats()
+{
+    unsigned long long begin = FlightNow();
+    WriteStatsFile(g_statsPath, &g_stats);
+    FlightSpan(FLIGHT_SAVE_STATS, 0, begin);
+}
+
+// --- Control Channel ---
+// Binds the control socket, which doubles as the single-instance guard:
+// false if another instance is already answering on it.
+bool OpenControlSocket()
+{
+    const char* dir = getenv("XDG_RUNTIME_DIR");
+    snprintf(g_controlPath, sizeof(g_controlPath), "%s/%s",
+             dir && *dir ? dir : "/tmp", CONTROL_SOCKET_NAME);
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, g_controlPath);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return true; // run without a control channel
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0)
+    {
+        fprintf(stderr, "already running (%s)\n", g_controlPath);
+        close(fd);
+        return false;
+    }
+    unlink(g_controlPath); // stale socket of an instance that died
+    mode_t mask = umask(077);
+    bool bound = bind(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0 &&
+                 listen(fd, 4) == 0;
+    umask(mask);
+    if (!bound)
+    {
+        fprintf(stderr, "no control socket at %s: %s\n", g_controlPath,
+                strerror(errno));
+        close(fd);
+        return true;
+    }
+    g_controlFd = fd;
+    return true;
+}
+
+// Serves one client at a time, away from the event loop
+void* ControlThread(void* arg)
+{
+    for (;;)
+    {
+        int client = accept(g_controlFd, NULL, NULL);
+        if (client < 0)
+        {
+            if (errno == EINTR) continue;
+            break;
+        }
+        struct timeval timeout = {1, 0};
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        ControlRequest req;
+        ControlReply reply;
+        if (read(client, &req, sizeof(req)) == sizeof(req))
+        {
+            if (BeginControlReply(&req, &reply))
+                HandleControlRequest(&req, &reply);
+            ssize_t ignored = write(client, &reply, sizeof(reply));
+            (void)ignored;
+        }
+        close(client);
+    }
+    return NULL;
+}
+
+void HandleControlRequest(const ControlRequest* req, ControlReply* reply)
+{
+    switch (req->command)
+    {
+    case CONTROL_PAUSE:
+    case CONTROL_RESUME:
+    case CONTROL_RELOAD:
+        // The event loop may be asleep in read(): keep poking it until it
+        // has run the command
+        g_controlStatus = CONTROL_FAILED;
+        g_controlCommand = (int)req->command;
+        for (int ms = 0; ms < 5000 && g_controlCommand.load(); ms++)
+        {
+            if (ms % 10 == 0) pthread_kill(g_mainThread, SIGUSR2);
+            LinuxWait(1);
+        }
+        reply->status = g_controlCommand.exchange(0) ? CONTROL_FAILED
+                                                     : g_controlStatus.load();
+        break;
+    case CONTROL_STATS:
+        reply->stats = g_stats;
+        reply->status = CONTROL_OK;
+        break;
+    case CONTROL_METRICS:
+        FillControlMetrics(&reply->metrics);
+        reply->status = CONTROL_OK;
+        break;
+    case CONTROL_DUMP_TRACE:
+        reply->status = DumpFlightTrace(g_flightTracePath) ? CONTROL_OK
+                                                           : CONTROL_FAILED;
+        snprintf(reply->path, sizeof(reply->path), "%.259s",
+                 g_flightTracePath);
+        break;
+    }
+}
+
+// Runs on the event loop
+void RunControlCommand()
+{
+    int command = g_controlCommand.load();
+    int status = CONTROL_OK;
+    switch (command)
+    {
+    case CONTROL_PAUSE:
+        g_paused = true;
+        StopScrolling();
+        break;
+    case CONTROL_RESUME:
+        g_paused = false;
+        break;
+    case CONTROL_RELOAD:
+    {
+        FILE* file = fopen(g_configPath, "r");
+        if (!file)
+        {
+            status = CONTROL_FAILED;
+            break;
+        }
+        fclose(file);
+        LoadConfig(g_configPath);
+        OpenTrace(g_config.trace_file, LinuxNow);
+        LoadStats();
+        break;
+    }
+    default:
+        status = CONTROL_UNSUPPORTED;
+        break;
+    }
+    g_controlStatus = status;
+    // Only clear the request we ran; a timed-out one was already dropped
+    g_controlCommand.compare_exchange_strong(command, 0);
+}
+
+void FillControlMetrics(ControlMetrics* m)
+{
+    long pages = 0, resident = 0, shared = 0;
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (statm)
+    {
+        if (fscanf(statm, "%ld %ld %ld", &pages, &resident, &shared) != 3)
+            resident = shared = 0;
+        fclose(statm);
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    m->paused = g_paused;
+    m->scroll_state = g_scrollState;
+    m->startup_ms = g_startupMs;
+    m->working_set = (unsigned long long)resident * sysconf(_SC_PAGESIZE);
+    // Resident pages not backed by a file (the binary, shared libraries)
+    m->private_bytes =
+        (unsigned long long)(resident - shared) * sysconf(_SC_PAGESIZE);
+    m->peak_working_set = (unsigned long long)usage.ru_maxrss * 1024;
+    m->realtime = g_realtime;
+    FillTickLatency(m);
+    m->gesture_input_calls = g_gestureInputCalls;
+}
@@ -0,0 +1,442 @@
+// Micro-benchmarks of the platform-neutral hot paths: the scroll curve, the
+// per-tick kernel, config parsing, stats persistence and indicator
+// rasterization. Results are JSON; with --compare, every case is checked
+// against a saved run and the exit code is 1 if one got slower than the
+// threshold or started producing different output.
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <chrono>
+
+#include "ScrollEngine.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define MAX_CASES 16
+#define SUBSAMPLES 4 // per pixel side when rasterizing the indicator
+
+typedef struct
+{
+    const char* name;
+    // Runs one batch, folds its output into *checksum, returns ops done
+    int (*Run)(unsigned long long* checksum);
+} BenchCase;
+
+typedef struct
+{
+    char name[64];
+    int ops;
+    double nsPerOp;
+    unsigned long long checksum;
+} BenchResult;
+
+// --- Options ---
+const char* g_configPath = "config.ini";
+char g_statsPath[260] = "scrollbench-stats.ini";
+bool g_quick = false;
+
+static unsigned long long Fold(unsigned long long sum, unsigned long long v)
+{
+    return (sum ^ v) * 1099511628211ULL; // FNV-1a step
+}
+
+// --- Cases: Scroll Kernel ---
+int RunCurve(unsigned long long* checksum)
+{
+    for (int delta = -1024; delta < 1024; delta++)
+    {
+        *checksum = Fold(*checksum, (unsigned int)CalculateScrollAmount(
+                                        delta, false));
+    }
+    return 2048;
+}
+
+static int RunKernel(Shape shape, unsigned long long* checksum)
+{
+    Shape saved = g_config.dead_zone_shape;
+    g_config.dead_zone_shape = shape;
+    for (int dy = -64; dy < 64; dy++)
+    {
+        for (int dx = -64; dx < 64; dx++)
+        {
+            ScrollTick t;
+            ComputeScrollTick(dx, dy, &t);
+            *checksum = Fold(*checksum, (unsigned int)t.vS * 31u +
+                                            (unsigned int)t.hS * 7u +
+                                            t.cursor * 2u + t.active);
+        }
+    }
+    g_config.dead_zone_shape = saved;
+    return 128 * 128;
+}
+
+int RunKernelCircle(unsigned long long* checksum)
+{
+    return RunKernel(SHAPE_CIRCLE, checksum);
+}
+
+int RunKernelSquare(unsigned long long* checksum)
+{
+    return RunKernel(SHAPE_SQUARE, checksum);
+}
+
+// --- Cases: Config & Stats ---
+int RunLoadConfig(unsigned long long* checksum)
+{
+    LoadConfig(g_configPath);
+    const unsigned char* p = (const unsigned char*)&g_config;
+    for (size_t i = 0; i < sizeof(AppConfig); i++)
+        *checksum = Fold(*checksum, p[i]);
+    return 1;
+}
+
+static const Stats g_sampleStats = {123456789012ULL, 40000000000ULL,
+                                    50000000000ULL,  1234567ULL,
+                                    7654321ULL,      98765ULL};
+
+int RunStatsWrite(unsigned long long* checksum)
+{
+    *checksum = Fold(*checksum, WriteStatsFile(g_statsPath, &g_sampleStats));
+    return 1;
+}
+
+int RunStatsRead(unsigned long long* checksum)
+{
+    Stats s;
+    ReadStatsFile(g_statsPath, &s);
+    *checksum = Fold(*checksum, s.total_pixels ^ s.dir_down ^ s.session_pixels);
+    return 1;
+}
+
+int RunStatsParse(unsigned long long* checksum)
+{
+    static const char text[] = "[Stats]\nTotalPixels=123456789012\n"
+                               "Up=40000000000\nDown=50000000000\n"
+                               "Left=1234567\nRight=7654321\n"
+                               "Unuploaded=98765\n";
+    Stats s;
+    ParseStatsText(text, sizeof(text) - 1, &s);
+    *checksum = Fold(*checksum, s.total_pixels ^ s.dir_right);
+    return 1;
+}
+
+// --- Cases: Indicator ---
+// Software model of DrawIndicator: the same shapes, anti-aliased by
+// supersampling into premultiplied BGRA like the shared asset pack holds.
+// GDI+ is not available here; this tracks the cost of the geometry.
+static bool InRect(double x, double y, double halfW, double halfH)
+{
+    return fabs(x) <= halfW && fabs(y) <= halfH;
+}
+
+static bool OnRect(double x, double y, double halfW, double halfH, double w)
+{
+    return InRect(x, y, halfW + w / 2, halfH + w / 2) &&
+           !InRect(x, y, halfW - w / 2, halfH - w / 2);
+}
+
+static bool OnCircle(double x, double y, double r, double w)
+{
+    return fabs(sqrt(x * x + y * y) - r) <= w / 2;
+}
+
+// Coverage of the main shape and of the outline at (x, y), relative to
+// the indicator centre, in 96-DPI units
+static void SampleIndicator(double x, double y, bool* main, bool* outline)
+{
+    double s = g_config.indicator_size;
+    double t = g_config.indicator_thickness;
+    double ot = g_config.outline_thickness;
+    double ct = g_config.indicator_cross_thickness;
+    bool filled = g_config.indicator_filled != 0;
+    bool show = g_config.show_outline != 0;
+    switch (g_config.indicator_shape)
+    {
+    case SHAPE_SQUARE:
+        *main = filled ? InRect(x, y, s, s) : OnRect(x, y, s, s, t);
+        if (filled)
+            *outline = show && OnRect(x, y, s, s, ot);
+        else
+            *outline = show && (OnRect(x, y, s + t / 2, s + t / 2, ot) ||
+                                OnRect(x, y, s - t / 2, s - t / 2, ot));
+        break;
+    case SHAPE_CROSS:
+        *main = InRect(x, y, s, ct) || InRect(x, y, ct, s);
+        *outline = show && (OnRect(x, y, s, ct, ot) || OnRect(x, y, ct, s, ot));
+        break;
+    case SHAPE_CIRCLE:
+    default:
+        if (filled)
+            *main = x * x + y * y <= s * s;
+        else
+            *main = OnCircle(x, y, s, t);
+        if (filled)
+            *outline = show && OnCircle(x, y, s, ot);
+        else
+            *outline = show && (OnCircle(x, y, s + t / 2, ot) ||
+                                OnCircle(x, y, s - t / 2, ot));
+        break;
+    }
+}
+
+void RasterizeIndicator(unsigned char* bgra, int extent, float scale)
+{
+    double centre = extent / 2.0;
+    const int n = SUBSAMPLES * SUBSAMPLES;
+    for (int py = 0; py < extent; py++)
+    {
+        for (int px = 0; px < extent; px++)
+        {
+            int mainHits = 0, outlineHits = 0;
+            for (int sy = 0; sy < SUBSAMPLES; sy++)
+            {
+                for (int sx = 0; sx < SUBSAMPLES; sx++)
+                {
+                    double x = (px + (sx + 0.5) / SUBSAMPLES - centre) / scale;
+                    double y = (py + (sy + 0.5) / SUBSAMPLES - centre) / scale;
+                    bool main, outline;
+                    SampleIndicator(x, y, &main, &outline);
+                    mainHits += main;
+                    outlineHits += outline;
+                }
+            }
+            // Outline over the main shape, source-over, premultiplied
+            double ma = g_config.indicator_color_a / 255.0 * mainHits / n;
+            double oa = g_config.outline_color_a / 255.0 * outlineHits / n;
+            double a = oa + ma * (1 - oa);
+            unsigned char* p = bgra + ((size_t)py * extent + px) * 4;
+            p[0] = (unsigned char)(g_config.outline_color_b * oa +
+                                   g_config.indicator_color_b * ma * (1 - oa));
+            p[1] = (unsigned char)(g_config.outline_color_g * oa +
+                                   g_config.indicator_color_g * ma * (1 - oa));
+            p[2] = (unsigned char)(g_config.outline_color_r * oa +
+                                   g_config.indicator_color_r * ma * (1 - oa));
+            p[3] = (unsigned char)(255 * a);
+        }
+    }
+}
+
+static int RunIndicator(int dpi, unsigned long long* checksum)
+{
+    static unsigned char* canvas = NULL;
+    static size_t capacity = 0;
+    float scale = dpi / 96.0f;
+    int extent = IndicatorExtent(scale);
+    size_t size = (size_t)extent * extent * 4;
+    if (size > capacity)
+    {
+        free(canvas);
+        canvas = (unsigned char*)malloc(size);
+        capacity = size;
+    }
+    RasterizeIndicator(canvas, extent, scale);
+    for (size_t i = 0; i < size; i += 4)
+        *checksum = Fold(*checksum, *(unsigned int*)(canvas + i));
+    return 1;
+}
+
+int RunIndicator96(unsigned long long* checksum)
+{
+    return RunIndicator(96, checksum);
+}
+
+int RunIndicator144(unsigned long long* checksum)
+{
+    return RunIndicator(144, checksum);
+}
+
+int RunIndicator192(unsigned long long* checksum)
+{
+    return RunIndicator(192, checksum);
+}
+
+const BenchCase g_cases[] = {
+    {"curve", RunCurve},
+    {"kernel_circle", RunKernelCircle},
+    {"kernel_square", RunKernelSquare},
+    {"load_config", RunLoadConfig},
+    {"stats_write", RunStatsWrite},
+    {"stats_read", RunStatsRead},
+    {"stats_parse", RunStatsParse},
+    {"indicator_96dpi", RunIndicator96},
+    {"indicator_144dpi", RunIndicator144},
+    {"indicator_192dpi", RunIndicator192},
+};
+const int g_caseCount = sizeof(g_cases) / sizeof(g_cases[0]);
+
+// --- Measurement ---
+// Fastest batch out of as many as fit in the time budget: the least
+// disturbed by the scheduler, so runs compare well.
+void Measure(const BenchCase* c, BenchResult* r)
+{
+    typedef std::chrono::steady_clock Clock;
+    double budget = g_quick ? 0.02 : 0.25; // seconds per case
+    double best = 1e30, spent = 0;
+    int ops = 0;
+    strncpy(r->name, c->name, sizeof(r->name) - 1);
+    r->name[sizeof(r->name) - 1] = 0;
+    for (int batch = 0; batch < 3 || spent < budget; batch++)
+    {
+        unsigned long long checksum = 14695981039346656037ULL;
+        Clock::time_point begin = Clock::now();
+        ops = c->Run(&checksum);
+        double elapsed =
+            std::chrono::duration<double>(Clock::now() - begin).count();
+        spent += elapsed;
+        if (elapsed < best) best = elapsed;
+        r->checksum = checksum; // every batch computes the same
+    }
+    r->ops = ops;
+    r->nsPerOp = best * 1e9 / ops;
+}
+
+void WriteJson(FILE* out, const BenchResult* results, int count)
+{
+    fprintf(out, "{\n  \"benchmark\": \"scrollbench\",\n  \"version\": 1,\n"
+                 "  \"results\": [\n");
+    for (int i = 0; i < count; i++)
+    {
+        fprintf(out,
+                "    {\"name\": \"%s\", \"ops\": %d, \"ns_per_op\": %.3f, "
+                "\"checksum\": \"%016llx\"}%s\n",
+                results[i].name, results[i].ops, results[i].nsPerOp,
+                results[i].checksum, i + 1 < count ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+// --- Comparison ---
+// Reads back what WriteJson wrote; not a general JSON parser
+int ReadJson(const char* path, BenchResult* results, int capacity)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file) return -1;
+    static char text[65536];
+    size_t length = fread(text, 1, sizeof(text) - 1, file);
+    fclose(file);
+    text[length] = 0;
+
+    int count = 0;
+    const char* p = text;
+    while (count < capacity && (p = strstr(p, "\"name\": \"")) != NULL)
+    {
+        BenchResult* r = &results[count];
+        memset(r, 0, sizeof(*r));
+        p += 9;
+        const char* end = strchr(p, '"');
+        if (!end) break;
+        size_t n = end - p < (long)sizeof(r->name) ? end - p
+                                                   : sizeof(r->name) - 1;
+        memcpy(r->name, p, n);
+        const char* field = strstr(end, "\"ns_per_op\": ");
+        if (field) r->nsPerOp = strtod(field + 13, NULL);
+        field = strstr(end, "\"checksum\": \"");
+        if (field) r->checksum = strtoull(field + 13, NULL, 16);
+        count++;
+        p = end;
+    }
+    return count;
+}
+
+// Prints one line per case; returns how many regressed or changed output
+int Compare(const BenchResult* current, int count, const BenchResult* base,
+            int baseCount, double threshold)
+{
+    int failures = 0;
+    for (int i = 0; i < count; i++)
+    {
+        const BenchResult* b = NULL;
+        for (int j = 0; j < baseCount && !b; j++)
+        {
+            if (strcmp(base[j].name, current[i].name) == 0) b = &base[j];
+        }
+        if (!b || b->nsPerOp <= 0)
+        {
+            fprintf(stderr, "%-18s %10.1f ns/op  (not in baseline)\n",
+                    current[i].name, current[i].nsPerOp);
+            continue;
+        }
+        double change = (current[i].nsPerOp / b->nsPerOp - 1.0) * 100.0;
+        const char* verdict = "ok";
+        if (current[i].checksum != b->checksum)
+            verdict = "OUTPUT CHANGED";
+        else if (change > threshold)
+            verdict = "REGRESSION";
+        if (strcmp(verdict, "ok") != 0) failures++;
+        fprintf(stderr, "%-18s %10.1f ns/op  baseline %10.1f  %+7.1f%%  %s\n",
+                current[i].name, current[i].nsPerOp, b->nsPerOp, change,
+                verdict);
+    }
+    return failures;
+}
+
+// --- Entry Point ---
+int main(int argc, char** argv)
+{
+    const char* outPath = NULL;
+    const char* baselinePath = NULL;
+    double threshold = 10.0; // percent
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--quick"))
+            g_quick = true;
+        else if (!strcmp(argv[i], "--out") && i + 1 < argc)
+            outPath = argv[++i];
+        else if (!strcmp(argv[i], "--compare") && i + 1 < argc)
+            baselinePath = argv[++i];
+        else if (!strcmp(argv[i], "--threshold") && i + 1 < argc)
+            threshold = atof(argv[++i]); // "10%" reads as 10
+        else if (!strcmp(argv[i], "--config") && i + 1 < argc)
+            g_configPath = argv[++i];
+        else if (!strcmp(argv[i], "--scratch") && i + 1 < argc)
+            snprintf(g_statsPath, sizeof(g_statsPath),
+                     "%s/scrollbench-stats.ini", argv[++i]);
+        else
+        {
+            fprintf(stderr,
+                    "usage: %s [--quick] [--out results.json] "
+                    "[--compare baseline.json [--threshold N%%]] "
+                    "[--config config.ini] [--scratch dir]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    // Every case runs against the same settings; the defaults apply where
+    // the file has no value
+    LoadConfig(g_configPath);
+    g_config.trace_file[0] = 0;
+    WriteStatsFile(g_statsPath, &g_sampleStats);
+
+    BenchResult results[MAX_CASES];
+    for (int i = 0; i < g_caseCount; i++) Measure(&g_cases[i], &results[i]);
+    remove(g_statsPath);
+
+    FILE* out = outPath ? fopen(outPath, "w") : stdout;
+    if (!out)
+    {
+        fprintf(stderr, "cannot write %s\n", outPath);
+        return 2;
+    }
+    WriteJson(out, results, g_caseCount);
+    if (out != stdout) fclose(out);
+
+    if (!baselinePath) return 0;
+    BenchResult baseline[MAX_CASES];
+    int baseCount = ReadJson(baselinePath, baseline, MAX_CASES);
+    if (baseCount <= 0)
+    {
+        fprintf(stderr, "%s: no results to compare against\n", baselinePath);
+        return 2;
+    }
+    int failures =
+        Compare(results, g_caseCount, baseline, baseCount, threshold);
+    fprintf(stderr, "%d of %d cases over the %.1f%% threshold or changed\n",
+            failures, g_caseCount, threshold);
+    return failures ? 1 : 0;
+}
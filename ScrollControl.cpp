@@ -0,0 +1,170 @@
+// Command-line client for the control channel of a running WinAutoScroll
+// (named pipe) or LinuxAutoScroll (Unix socket). Sends one command, prints
+// the answer as key=value lines and exits 0 on success. 'metrics --budget
+// [mb]' also fails with 3 when the working set is over the budget (the
+// README's figure by default), for checks on idle machines.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "ScrollEngine.h"
+
+// --- Transport ---
+#ifdef _WIN32
+bool Exchange(const ControlRequest* req, ControlReply* reply)
+{
+    // The instance of this logon session, not another user's
+    DWORD session = 0, serverSession = 0;
+    ProcessIdToSessionId(GetCurrentProcessId(), &session);
+    char name[64];
+    ControlPipeName(name, sizeof(name), session);
+
+    HANDLE pipe = INVALID_HANDLE_VALUE;
+    for (int attempt = 0; attempt < 2; attempt++)
+    {
+        pipe = CreateFile(name, GENERIC_READ | GENERIC_WRITE, 0, NULL,
+                          OPEN_EXISTING, 0, NULL);
+        // Busy serving another client: wait until it disconnects
+        if (pipe != INVALID_HANDLE_VALUE ||
+            GetLastError() != ERROR_PIPE_BUSY || !WaitNamedPipe(name, 2000))
+            break;
+    }
+    if (pipe == INVALID_HANDLE_VALUE) return false;
+
+    // A pipe squatted from another session does not get the request
+    ULONG server = 0;
+    if (!GetNamedPipeServerProcessId(pipe, &server) ||
+        !ProcessIdToSessionId(server, &serverSession) ||
+        serverSession != session)
+    {
+        CloseHandle(pipe);
+        return false;
+    }
+
+    DWORD mode = PIPE_READMODE_MESSAGE, n = 0;
+    SetNamedPipeHandleState(pipe, &mode, NULL, NULL);
+    bool ok = WriteFile(pipe, req, sizeof(ControlRequest), &n, NULL) &&
+              ReadFile(pipe, reply, sizeof(ControlReply), &n, NULL) &&
+              n == sizeof(ControlReply);
+    CloseHandle(pipe);
+    return ok;
+}
+#else
+bool Exchange(const ControlRequest* req, ControlReply* reply)
+{
+    const char* dir = getenv("XDG_RUNTIME_DIR");
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s/%s",
+             dir && *dir ? dir : "/tmp", CONTROL_SOCKET_NAME);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+    bool ok = connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0 &&
+              write(fd, req, sizeof(ControlRequest)) ==
+                  (ssize_t)sizeof(ControlRequest);
+    size_t got = 0;
+    while (ok && got < sizeof(ControlReply))
+    {
+        ssize_t n = read(fd, (char*)reply + got, sizeof(ControlReply) - got);
+        if (n <= 0) ok = false;
+        else got += (size_t)n;
+    }
+    close(fd);
+    return ok;
+}
+#endif
+
+// --- Entry Point ---
+int main(int argc, char** argv)
+{
+    static const char* commands[] = {"pause",   "resume",  "reload",
+                                     "stats",   "metrics", "dump-trace"};
+    unsigned int command = 0;
+    for (int i = 0; argc > 1 && i < 6; i++)
+    {
+        if (!strcmp(argv[1], commands[i])) command = CONTROL_PAUSE + i;
+    }
+    double budget = 0.0; // bytes, 0 = not checked
+    if (command == CONTROL_METRICS && argc > 2 && !strcmp(argv[2], "--budget"))
+        budget = argc > 3 ? atof(argv[3]) * 1048576.0
+                          : (double)MEMORY_BUDGET_BYTES;
+    if (!command || (command == CONTROL_METRICS && argc > 2 && budget <= 0.0))
+    {
+        fprintf(stderr,
+                "usage: %s pause|resume|reload|stats|metrics|dump-trace\n"
+                "       %s metrics --budget [mb]\n",
+                argv[0], argv[0]);
+        return 1;
+    }
+
+    ControlRequest req = {CONTROL_MAGIC, CONTROL_VERSION, command};
+    ControlReply reply;
+    if (!Exchange(&req, &reply))
+    {
+        fprintf(stderr, "no running instance answered\n");
+        return 1;
+    }
+    if (reply.magic != CONTROL_MAGIC || reply.version != CONTROL_VERSION ||
+        reply.status == CONTROL_UNSUPPORTED)
+    {
+        fprintf(stderr, "%s: not supported by the running instance\n",
+                argv[1]);
+        return 2;
+    }
+    if (reply.status != CONTROL_OK)
+    {
+        fprintf(stderr, "%s: failed\n", argv[1]);
+        return 2;
+    }
+
+    switch (command)
+    {
+    case CONTROL_STATS:
+        printf("total_pixels=%llu\nsession_pixels=%llu\n"
+               "dir_up=%llu\ndir_down=%llu\ndir_left=%llu\ndir_right=%llu\n",
+               reply.stats.total_pixels, reply.stats.session_pixels,
+               reply.stats.dir_up, reply.stats.dir_down, reply.stats.dir_left,
+               reply.stats.dir_right);
+        break;
+    case CONTROL_METRICS:
+    {
+        const ControlMetrics* m = &reply.metrics;
+        printf("paused=%d\nscroll_state=%d\nstartup_ms=%.1f\n"
+               "working_set=%llu\npeak_working_set=%llu\nprivate_bytes=%llu\n"
+               "feedback_updates=%llu\nfeedback_latency_avg_ms=%.3f\n"
+               "feedback_latency_max_ms=%.3f\nrealtime=%d\nticks=%llu\n"
+               "tick_late_p50_ms=%.1f\ntick_late_p99_ms=%.1f\n"
+               "tick_late_max_ms=%.3f\ngesture_input_calls=%llu\n",
+               m->paused, m->scroll_state, m->startup_ms, m->working_set,
+               m->peak_working_set, m->private_bytes, m->feedback_updates,
+               m->feedback_latency_avg_ms, m->feedback_latency_max_ms,
+               m->realtime, m->ticks, m->tick_late_p50_ms,
+               m->tick_late_p99_ms, m->tick_late_max_ms,
+               m->gesture_input_calls);
+        if (budget > 0.0)
+        {
+            bool within = m->working_set <= budget;
+            printf("budget=%.0f\nbudget_ok=%d\n", budget, within);
+            if (!within) return 3;
+        }
+        break;
+    }
+    case CONTROL_DUMP_TRACE:
+        printf("path=%s\n", reply.path);
+        break;
+    default:
+        printf("ok\n");
+        break;
+    }
+    return 0;
+}
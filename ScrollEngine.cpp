@@ -0,0 +1,1703 @@
+#define _USE_MATH_DEFINES
+#define _CRT_SECURE_NO_WARNINGS
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include <chrono>
+#include <mutex>
+
+#include "ScrollEngine.h"
+
+// clang-format off
+// lets disable bin packing here
+AppConfig g_config = {
+    1,
+    1000,
+    0.01f,
+    4.0f,
+    60,
+    0,
+    1,
+    0,
+    MODE_HOLD,
+    1,
+    1,
+    0,
+    SHAPE_CIRCLE,
+    1,
+    5,
+    0,
+    1,
+    SHAPE_CIRCLE,
+    26,
+    10,
+    255,
+    255,
+    255,
+    180,
+    6.0f,
+    0,
+    1,
+    0,
+    1,
+    1.0f,
+    100,
+    100,
+    100,
+    255,
+    FILTER_NONE,
+    0.5f,
+    1.0f,
+    0.02f,
+    1.0f,
+    0,
+    0,
+    3,
+    100,
+    30,
+    {{0}},
+    0,
+    0x1B,
+    0x13,
+    0x26,
+    0x28,
+    10.0f,
+    1,
+    1.2f,
+    0,
+    0,
+    -1,
+    "",
+    ""
+};
+// clang-format on
+Stats g_stats = {0};
+
+// --- Global State ---
+volatile ScrollState g_scrollState = STATE_IDLE;
+ScrollPoint g_startScrollPos, g_primeStartPos;
+std::atomic<unsigned long long> g_targetVelocity(0);
+std::atomic<unsigned long long> g_cruiseVelocity(0);
+TriggerTable g_triggers;
+volatile int g_activeBinding = 0;
+MotionProfile g_motion = {96, 1, 0, 5, 1.0f}; // rescaled by LoadConfig
+
+// --- Trace State ---
+std::mutex g_traceLock;
+FILE* g_traceFile = NULL;
+double (*g_traceClock)() = NULL;
+
+// --- Tick Latency State ---
+// How late the scroll threads wake up for a tick, in 0.1 ms buckets; the
+// last bucket also takes everything beyond it.
+#define TICK_LATENCY_BUCKETS 256
+std::atomic<unsigned int> g_tickLatency[TICK_LATENCY_BUCKETS];
+std::atomic<unsigned int> g_tickLatencyMaxUs(0);
+
+// --- Flight Recorder State ---
+#define FLIGHT_MAX_THREADS 8
+#define FLIGHT_RING_SIZE 4096 // records per thread, power of two
+
+typedef struct
+{
+    unsigned long long begin; // ns since process start
+    unsigned int duration;    // ns
+    unsigned char event, owner; // owner: FlightRing.owner when written
+    short arg;
+} FlightRecord;
+
+// Single writer (the owning thread); DumpFlightTrace reads it racily, which
+// at worst shows a record that is being overwritten. A ring outlives its
+// threads, so each thread that claims it is a new owner generation with
+// its own name; the trace tid is ring * 256 + owner.
+typedef struct
+{
+    FlightRecord records[FLIGHT_RING_SIZE];
+    std::atomic<unsigned int> head;
+    std::atomic<bool> inUse;
+    unsigned char owner;
+    char names[256][16]; // per owner generation
+} FlightRing;
+
+FlightRing g_flightRings[FLIGHT_MAX_THREADS];
+std::atomic<unsigned int> g_flightNextRing(0);
+const std::chrono::steady_clock::time_point g_flightEpoch =
+    std::chrono::steady_clock::now();
+thread_local FlightRing* t_flightRing = NULL;
+thread_local bool t_flightRegistered = false;
+
+// --- Motion Profiles ---
+static int ScalePixels(int px, float scale)
+{
+    return px < 0 ? px : (int)(px * scale + 0.5f);
+}
+
+// Backends build one profile per monitor up front; a gesture only picks one.
+void ScaleMotionProfile(MotionProfile* m, int dpi)
+{
+    if (!g_config.dpi_scaling || dpi <= 0) dpi = 96;
+    float scale = dpi / 96.0f;
+    m->dpi = dpi;
+    m->dead_zone = ScalePixels(g_config.dead_zone, scale);
+    m->drag_threshold = ScalePixels(g_config.drag_threshold, scale);
+    m->axis_lock_threshold =
+        ScalePixels(g_config.axis_lock_threshold, scale);
+    m->input_scale = 1.0f / scale;
+}
+
+// Only while no worker is running: the kernel reads g_motion unlocked.
+void SelectMotionProfile(const MotionProfile* m)
+{
+    TraceEvent(TRACE_MOTION, m->dpi, 0);
+    g_motion = *m;
+}
+
+// --- Trigger State Machine ---
+// All transitions run on one thread (the backend's event loop); the scroll
+// workers only ever read g_scrollState.
+static TriggerMode ActiveMode()
+{
+    return g_triggers.bindings[g_activeBinding].mode;
+}
+
+static float ActiveSensitivity()
+{
+    float s = g_triggers.bindings[g_activeBinding].sensitivity;
+    return (s > 0.0f ? s : g_config.sensitivity) * g_motion.input_scale;
+}
+
+// Wheel units per physical pixel of the gesture's monitor
+static float ActivePanScale()
+{
+    float s = g_triggers.bindings[g_activeBinding].sensitivity;
+    return (s > 0.0f ? s : g_config.pan_scale) * g_motion.input_scale;
+}
+
+TriggerAction OnTriggerButtonDown(int binding, int x, int y)
+{
+    TraceTriggerEvent(TRACE_BUTTON_DOWN, binding, x, y);
+    if (g_scrollState == STATE_IDLE)
+    {
+        g_scrollState = STATE_PRIMED;
+        g_activeBinding = binding;
+        g_primeStartPos.x = x;
+        g_primeStartPos.y = y;
+    }
+    else if (g_scrollState == STATE_SCROLLING && ActiveMode() == MODE_TOGGLE)
+    {
+        return ACTION_STOP;
+    }
+    return ACTION_NONE;
+}
+
+TriggerAction OnTriggerButtonUp(int binding)
+{
+    TraceTriggerEvent(TRACE_BUTTON_UP, binding, 0, 0);
+    if (binding != g_activeBinding) return ACTION_NONE;
+    if (g_scrollState == STATE_PRIMED)
+    {
+        g_scrollState = STATE_IDLE;
+        if (g_config.middle_mouse_passthrough) return ACTION_CLICK;
+    }
+    else if (g_scrollState == STATE_SCROLLING && ActiveMode() == MODE_HOLD)
+    {
+        return ACTION_STOP;
+    }
+    return ACTION_NONE;
+}
+
+// Cheap enough for input hooks, which use it to forward only the move
+// that starts the gesture.
+bool PastDragThreshold(int x, int y, int primeX, int primeY, int threshold)
+{
+    return abs(x - primeX) > threshold || abs(y - primeY) > threshold;
+}
+
+// The hook thread arms, disarms and crosses; the exchange keeps a second
+// move from crossing again before the event loop has seen the first.
+void ArmDragGate(DragGate* g, int x, int y, int threshold)
+{
+    g->prime.store((unsigned long long)(unsigned int)x << 32 |
+                   (unsigned int)y);
+    g->threshold = threshold;
+    g->armed.store(true);
+}
+
+void DisarmDragGate(DragGate* g)
+{
+    g->armed.store(false);
+}
+
+bool CrossDragGate(DragGate* g, int x, int y)
+{
+    if (!g->armed.load()) return false;
+    unsigned long long prime = g->prime.load();
+    return PastDragThreshold(x, y, (int)(unsigned int)(prime >> 32),
+                             (int)(unsigned int)prime, g->threshold) &&
+           g->armed.exchange(false);
+}
+
+TriggerAction OnPrimedMove(int x, int y)
+{
+    TraceEvent(TRACE_PRIMED_MOVE, x, y);
+    if (g_scrollState == STATE_PRIMED)
+    {
+        if (PastDragThreshold(x, y, g_primeStartPos.x, g_primeStartPos.y,
+                              g_motion.drag_threshold))
+            return ACTION_START;
+    }
+    return ACTION_NONE;
+}
+
+TriggerAction OnTriggerKeyDown(int binding)
+{
+    TraceTriggerEvent(TRACE_KEY_DOWN, binding, 0, 0);
+    TriggerMode mode = g_triggers.bindings[binding].mode;
+    if (g_scrollState == STATE_SCROLLING)
+        return mode == MODE_HOLD ? ACTION_NONE : ACTION_STOP;
+    if (g_scrollState == STATE_IDLE || mode == MODE_HOLD)
+    {
+        g_activeBinding = binding;
+        return ACTION_START;
+    }
+    return ACTION_NONE;
+}
+
+TriggerAction OnTriggerKeyUp(int binding)
+{
+    TraceTriggerEvent(TRACE_KEY_UP, binding, 0, 0);
+    if (binding == g_activeBinding && ActiveMode() == MODE_HOLD)
+        return ACTION_STOP;
+    return ACTION_NONE;
+}
+
+TriggerAction OnCancel()
+{
+    TraceEvent(TRACE_CANCEL, 0, 0);
+    if (g_scrollState == STATE_PRIMED)
+    {
+        g_scrollState = STATE_IDLE;
+        return ACTION_NONE;
+    }
+    return ACTION_STOP;
+}
+
+// Anchors at the prime position if primed, else at (x, y). Returns false
+// if scrolling was not started.
+bool BeginScrolling(int x, int y)
+{
+    if (g_scrollState != STATE_IDLE && g_scrollState != STATE_PRIMED)
+        return false;
+    if (g_scrollState == STATE_IDLE)
+    {
+        g_startScrollPos.x = x;
+        g_startScrollPos.y = y;
+    }
+    else
+    {
+        g_startScrollPos = g_primeStartPos;
+    }
+    g_cruiseVelocity.store(0);
+    g_scrollState = STATE_SCROLLING;
+    TraceEvent(TRACE_BEGIN, g_startScrollPos.x, g_startScrollPos.y);
+    return true;
+}
+
+bool EndScrolling()
+{
+    if (g_scrollState != STATE_SCROLLING) return false;
+    g_scrollState = STATE_STOPPING;
+    g_cruiseVelocity.store(0);
+    TraceEvent(TRACE_END, 0, 0);
+    return true;
+}
+
+// Cheap enough for input hooks, which wake the sampler on every move of a
+// grab-pan gesture.
+bool IsPanGesture()
+{
+    return g_triggers.bindings[g_activeBinding].pan != 0;
+}
+
+// Called by the input thread for every swallowed press of a bound button.
+// g_scrollState may lag behind on Win32, where the hook only posts events,
+// so a press already held also keeps a second one from being claimed.
+void PressHeldButton(HeldButtons* h, int button, int binding)
+{
+    if (h->button == 0 &&
+        (g_scrollState == STATE_IDLE || g_scrollState == STATE_PRIMED))
+    {
+        h->button = button;
+        h->binding = binding;
+    }
+    else if (button != h->button)
+    {
+        h->swallowed |= button;
+    }
+}
+
+// True if the release belongs to a swallowed press. *binding is the
+// binding to report as released, or -1 if the state machine never needs
+// to see it.
+bool ReleaseHeldButton(HeldButtons* h, int button, int* binding)
+{
+    *binding = -1;
+    if (button != 0 && button == h->button)
+    {
+        *binding = h->binding;
+        h->button = 0;
+        return true;
+    }
+    if (h->swallowed & button)
+    {
+        h->swallowed &= ~button;
+        return true;
+    }
+    return false;
+}
+
+// --- Cruise ---
+// Locks the rate the sampler last published; the pointer is ignored until
+// the cruise key is pressed again. The sampler traces what it picks up.
+void OnCruiseToggle()
+{
+    if (g_scrollState != STATE_SCROLLING || IsPanGesture()) return;
+    if (IsCruising())
+        g_cruiseVelocity.store(0);
+    else
+        g_cruiseVelocity.store(g_targetVelocity.load());
+}
+
+void OnCruiseNudge(int direction)
+{
+    VelocityMailbox m;
+    m.bits = g_cruiseVelocity.load();
+    if (!m.bits) return;
+    float factor = 1.0f + direction * g_config.cruise_step / 100.0f;
+    if (factor <= 0.0f) return;
+    m.rate.v *= factor;
+    m.rate.h *= factor;
+    if (m.bits) g_cruiseVelocity.store(m.bits);
+}
+
+bool IsCruising()
+{
+    return g_cruiseVelocity.load() != 0;
+}
+
+// --- Scroll Kernel ---
+int CalculateScrollAmount(int delta, bool isTouchpad)
+{
+    if (delta == 0) return 0;
+    double val = pow(abs(delta) * ActiveSensitivity(), g_config.ramp_exponent);
+    int res = (int)val;
+    if (res < g_config.min_scroll) res = g_config.min_scroll;
+    if (val > g_config.max_scroll) val = (double)g_config.max_scroll;
+    return (delta < 0 ? -res : res);
+}
+
+// Smoothing factor of a first-order low-pass at the given cutoff (Hz)
+static double LowPassAlpha(double cutoff, double dt)
+{
+    double tau = 1.0 / (2.0 * M_PI * cutoff);
+    return 1.0 / (1.0 + tau / dt);
+}
+
+// One Euro filter: heavy smoothing while the hand is still, low lag while
+// it moves. EMA is a plain fixed-weight fallback.
+double FilterOffset(AxisFilter* f, double raw, double dt)
+{
+    if (!f->primed || dt <= 0.0)
+    {
+        if (!f->primed) f->value = raw;
+        f->velocity = 0.0;
+        f->primed = true;
+        return f->value;
+    }
+
+    if (g_config.input_filter == FILTER_EMA)
+    {
+        f->value += g_config.filter_ema_alpha * (raw - f->value);
+        return f->value;
+    }
+
+    double rawVelocity = (raw - f->value) / dt;
+    f->velocity +=
+        LowPassAlpha(g_config.filter_d_cutoff, dt) * (rawVelocity - f->velocity);
+    double cutoff =
+        g_config.filter_min_cutoff + g_config.filter_beta * fabs(f->velocity);
+    f->value += LowPassAlpha(cutoff, dt) * (raw - f->value);
+    return f->value;
+}
+
+void ComputeScrollTick(int dx, int dy, ScrollTick* out)
+{
+    out->vS = out->hS = 0;
+    out->cursor = CURSOR_ALL;
+
+    // 1. Dead Zone Check
+    if (g_config.dead_zone_shape == SHAPE_SQUARE)
+    {
+        out->active =
+            (abs(dx) > g_motion.dead_zone || abs(dy) > g_motion.dead_zone);
+    }
+    else
+    {
+        out->active =
+            (sqrt((double)dx * dx + (double)dy * dy) > g_motion.dead_zone);
+    }
+    if (!out->active) return;
+
+    // 2. Calculate Raw Magnitude
+    int vS = CalculateScrollAmount(dy, g_config.emulate_touchpad_scrolling);
+    int hS = CalculateScrollAmount(dx, g_config.emulate_touchpad_scrolling);
+
+    // 3. Axis Locking
+    bool lockedVertically = false;
+    bool lockedHorizontally = false;
+    if (g_motion.axis_lock_threshold > 0)
+    {
+        int adx = abs(dx);
+        int ady = abs(dy);
+        if (ady >= adx)
+        {
+            if (adx <= g_motion.axis_lock_threshold) lockedVertically = true;
+        }
+        else
+        {
+            if (ady <= g_motion.axis_lock_threshold) lockedHorizontally = true;
+        }
+    }
+    if (lockedVertically) hS = 0;
+    if (lockedHorizontally) vS = 0;
+
+    // 4. Natural Scrolling
+    if (g_config.natural_scrolling)
+    {
+        vS = -vS;
+        hS = -hS;
+    }
+
+    // 5. Wheel Inversion (Standard Line Scrolling needs this)
+    if (!g_config.emulate_touchpad_scrolling) vS = -vS;
+
+    out->vS = vS;
+    out->hS = hS;
+
+    // 6. Direction Classification (drives the cursor)
+    if (lockedVertically)
+        out->cursor = CURSOR_NS;
+    else if (lockedHorizontally)
+        out->cursor = CURSOR_WE;
+    else
+    {
+        double angle = atan2((double)dy, (double)dx) * 180.0 / M_PI;
+        if (fabs(angle) <= 22.5 || fabs(angle) >= 157.5)
+            out->cursor = CURSOR_WE;
+        else if (fabs(angle) >= 67.5 && fabs(angle) <= 112.5)
+            out->cursor = CURSOR_NS;
+        else
+        {
+            if ((dx > 0 && dy > 0) || (dx < 0 && dy < 0))
+                out->cursor = CURSOR_NWSE;
+            else
+                out->cursor = CURSOR_NESW;
+        }
+    }
+}
+
+// Grab-pan: the pointer's motion since the last tick, scaled to wheel
+// units so the content moves with it. Sub-unit remainders are carried, so
+// a slow drag covers the same distance as a fast one. Dead zone, curve,
+// axis lock and natural_scrolling do not apply.
+void ComputePanTick(SamplerState* s, int x, int y, ScrollTick* out)
+{
+    float scale = ActivePanScale();
+    // Dragging down pulls the content down: positive wheel, towards the
+    // top. Dragging right scrolls towards the left.
+    s->panAccV += (double)(y - s->panY) * scale;
+    s->panAccH -= (double)(x - s->panX) * scale;
+    s->panX = x;
+    s->panY = y;
+    out->active = true;
+    out->cursor = CURSOR_ALL;
+    out->vS = (int)s->panAccV;
+    out->hS = (int)s->panAccH;
+    s->panAccV -= out->vS;
+    s->panAccH -= out->hS;
+}
+
+void PublishVelocity(float v, float h)
+{
+    VelocityMailbox m;
+    m.rate.v = v;
+    m.rate.h = h;
+    g_targetVelocity.store(m.bits);
+}
+
+void StepEmitter(EmitterState* e, double dt, int* vS, int* hS)
+{
+    VelocityMailbox m;
+    m.bits = g_targetVelocity.load();
+
+    // Glide towards the latest sample over one sampling period so the
+    // output has no steps when the two rates differ.
+    double t = dt * SampleFrequency();
+    if (t > 1.0) t = 1.0;
+    e->curV += (m.rate.v - e->curV) * t;
+    e->curH += (m.rate.h - e->curH) * t;
+
+    if (m.rate.v == 0.0f) e->curV = e->accV = 0.0;
+    if (m.rate.h == 0.0f) e->curH = e->accH = 0.0;
+
+    e->accV += e->curV * dt;
+    e->accH += e->curH * dt;
+    *vS = (int)e->accV;
+    *hS = (int)e->accH;
+    e->accV -= *vS;
+    e->accH -= *hS;
+}
+
+int SampleFrequency()
+{
+    int freq = g_config.update_frequency;
+    if (freq <= 0) freq = 60;
+    return freq;
+}
+
+// --- Wheel Flow Control ---
+// Seconds between the EmitScroll calls of the current gesture
+static double EmitInterval()
+{
+    if (g_config.output_frequency > 0 && !IsPanGesture())
+        return 1.0 / g_config.output_frequency;
+    return 1.0 / SampleFrequency();
+}
+
+// Messages to send for the pending deltas, into out[WHEEL_TICK_MESSAGES].
+// With maxOutstanding > 0, nothing goes out while that many are
+// unacknowledged, and the vertical message (else the horizontal one) asks
+// for an acknowledgement.
+int PlanWheelMessages(WheelFlow* f, int maxOutstanding, double now,
+                      WheelMessage* out)
+{
+    if (f->pendingV == 0 && f->pendingH == 0) return 0;
+    // Acknowledgements are collected while the worker waits for its next
+    // tick, so a target that keeps up answers within about one interval.
+    // Slower than that it cannot drain a deeper queue either: keep one
+    // message in flight and merge everything else into the next one.
+    if (maxOutstanding > 1 &&
+        f->rtt > WHEEL_SLOW_TARGET_TICKS * EmitInterval())
+        maxOutstanding = 1;
+    if (maxOutstanding > 0 && f->outstanding >= maxOutstanding) return 0;
+
+    int sendV = f->pendingV < -32767  ? -32767
+                : f->pendingV > 32767 ? 32767
+                                      : f->pendingV;
+    int sendH = f->pendingH < -32767  ? -32767
+                : f->pendingH > 32767 ? 32767
+                                      : f->pendingH;
+    f->pendingV -= sendV;
+    f->pendingH -= sendH;
+    int n = 0;
+    if (sendV != 0)
+    {
+        WheelMessage m = {0, sendV, maxOutstanding > 0};
+        out[n++] = m;
+    }
+    if (sendH != 0)
+    {
+        WheelMessage m = {1, sendH, maxOutstanding > 0 && sendV == 0};
+        out[n++] = m;
+    }
+    if (maxOutstanding > 0 && f->outstanding++ == 0) f->waiting = now;
+    return n;
+}
+
+void AckWheelMessage(WheelFlow* f, double rtt, double now)
+{
+    if (f->outstanding > 0) f->outstanding--;
+    f->waiting = now; // the next one is waited for from here
+    if (rtt < 0.0) return;
+    f->rtt = f->rtt == 0.0 ? rtt : f->rtt + (rtt - f->rtt) * 0.125;
+}
+
+// True once nothing has been acknowledged for the round trip and
+// WHEEL_OVERDUE_TICKS more: only then is the target worth asking about.
+// A target that keeps up, however slowly, never gets there.
+bool WheelAckOverdue(const WheelFlow* f, double now)
+{
+    return f->outstanding > 0 &&
+           now - f->waiting > f->rtt + WHEEL_OVERDUE_TICKS * EmitInterval();
+}
+
+void ResetWheelFlow(WheelFlow* f)
+{
+    f->outstanding = 0;
+    f->pendingV = f->pendingH = 0;
+    f->rtt = 0.0; // the next gesture may have another target
+    f->waiting = 0.0;
+}
+
+// --- Workers ---
+void BeginSampler(SamplerState* s, bool decoupled)
+{
+    memset(s, 0, sizeof(SamplerState));
+    s->cursor = CURSOR_ALL; // set by the backend on start
+    s->last = -1.0;
+    // Grab-pan emits from the sampler so a move is sent on the tick that
+    // saw it, starting from the anchor the gesture grabbed.
+    s->pan = IsPanGesture();
+    s->decoupled = decoupled && !s->pan;
+    s->panX = g_startScrollPos.x;
+    s->panY = g_startScrollPos.y;
+}
+
+// Records an engine-side event stamped with the tick time instead of the
+// trace clock, so replays can reproduce it exactly.
+static void TraceAt(TraceType type, int binding, int a, int b, double time)
+{
+    TraceRecord r = {(unsigned int)type, a, b, binding, time};
+    fwrite(&r, sizeof(r), 1, g_traceFile);
+}
+
+void SamplerTick(SamplerState* s, const ScrollBackend* b)
+{
+    unsigned long long begin = FlightNow();
+    int x, y;
+    b->GetPointer(&x, &y);
+    double now = b->Now();
+    double dt = s->last < 0.0 ? 0.0 : now - s->last;
+    s->last = now;
+
+    ScrollTick tick;
+    float rateV = 0.0f, rateH = 0.0f; // grab-pan leaves nothing to cruise
+    if (s->pan)
+    {
+        ComputePanTick(s, x, y, &tick);
+    }
+    else
+    {
+        int dx = x - g_startScrollPos.x;
+        int dy = y - g_startScrollPos.y;
+
+        // 0. Input Smoothing (removes sensor jitter before the ramp curve)
+        if (g_config.input_filter != FILTER_NONE)
+        {
+            dx = (int)floor(FilterOffset(&s->filterX, dx, dt) + 0.5);
+            dy = (int)floor(FilterOffset(&s->filterY, dy, dt) + 0.5);
+        }
+
+        ComputeScrollTick(dx, dy, &tick);
+        int freq = SampleFrequency();
+        rateV = (float)tick.vS * freq;
+        rateH = (float)tick.hS * freq;
+    }
+
+    // Cruise: the locked rate replaces the pointer. Emission is paced by
+    // the clock, not the tick count, so late or dropped ticks do not
+    // change the distance covered.
+    VelocityMailbox cruise;
+    cruise.bits = g_cruiseVelocity.load();
+    bool cruiseChanged = cruise.bits != s->cruise;
+    s->cruise = cruise.bits;
+    if (cruise.bits)
+    {
+        rateV = cruise.rate.v;
+        rateH = cruise.rate.h;
+        tick.active = true;
+        tick.cursor = s->cursor;
+        s->cruiseAccV += rateV * dt;
+        s->cruiseAccH += rateH * dt;
+        tick.vS = (int)s->cruiseAccV;
+        tick.hS = (int)s->cruiseAccH;
+        s->cruiseAccV -= tick.vS;
+        s->cruiseAccH -= tick.hS;
+    }
+    else
+    {
+        s->cruiseAccV = s->cruiseAccH = 0.0;
+    }
+
+    // The published rate is what a cruise key locks. Decoupled mode: the
+    // emitter interpolates it and emits at output_frequency. While tracing,
+    // the publish and its record are ordered against the emitter's read.
+    if (g_traceFile)
+    {
+        std::lock_guard<std::mutex> lock(g_traceLock);
+        if (g_traceFile)
+        {
+            if (cruiseChanged)
+                TraceAt(TRACE_CRUISE, 0, (int)(unsigned int)cruise.bits,
+                        (int)(unsigned int)(cruise.bits >> 32), now);
+            TraceAt(TRACE_SAMPLE, 0, x, y, now);
+            PublishVelocity(rateV, rateH);
+            if (!s->decoupled && tick.active && (tick.vS != 0 || tick.hS != 0))
+                TraceAt(TRACE_EMIT, 0, tick.vS, tick.hS, now);
+        }
+    }
+    else
+    {
+        PublishVelocity(rateV, rateH);
+    }
+    if (!s->decoupled && tick.active) b->EmitScroll(tick.vS, tick.hS);
+
+    if (s->cursor != tick.cursor)
+    {
+        b->SetFeedback(tick.cursor);
+        s->cursor = tick.cursor;
+    }
+    FlightSpan(FLIGHT_SAMPLER_TICK, tick.active, begin);
+}
+
+void EmitterTick(EmitterState* e, const ScrollBackend* b)
+{
+    unsigned long long begin = FlightNow();
+    double now = b->Now();
+    double dt = e->last < 0.0 ? 0.0 : now - e->last;
+    e->last = now;
+
+    int vS, hS;
+    if (g_traceFile)
+    {
+        std::lock_guard<std::mutex> lock(g_traceLock);
+        StepEmitter(e, dt, &vS, &hS);
+        if (g_traceFile)
+        {
+            TraceAt(TRACE_EMITTER_TICK, 0, 0, 0, now);
+            if (vS != 0 || hS != 0) TraceAt(TRACE_EMIT, 0, vS, hS, now);
+        }
+    }
+    else
+    {
+        StepEmitter(e, dt, &vS, &hS);
+    }
+    b->EmitScroll(vS, hS);
+    FlightSpan(FLIGHT_EMITTER_TICK, vS != 0 || hS != 0, begin);
+}
+
+void RunSampler(const ScrollBackend* b, bool decoupled)
+{
+    FlightNameThread("sampler");
+    SamplerState s;
+    BeginSampler(&s, decoupled);
+    while (g_scrollState == STATE_SCROLLING)
+    {
+        SamplerTick(&s, b);
+        // Grab-pan ticks on pointer motion; the timeout only notices a stop
+        int ms = 1000 / SampleFrequency();
+        if (s.pan)
+        {
+            b->WaitInput(ms);
+        }
+        else
+        {
+            double due = b->Now() + ms / 1000.0;
+            b->WaitSample(ms);
+            RecordTickLatency(b->Now() - due);
+        }
+    }
+}
+
+void RunEmitter(const ScrollBackend* b)
+{
+    FlightNameThread("emitter");
+    EmitterState e = {0};
+    e.last = -1.0;
+    while (g_scrollState == STATE_SCROLLING)
+    {
+        // Vsync waits end on the display's schedule, not after ms
+        int ms = 1000 / g_config.output_frequency;
+        double due = b->Now() + ms / 1000.0;
+        b->WaitOutput(ms);
+        if (!g_config.output_vsync) RecordTickLatency(b->Now() - due);
+        EmitterTick(&e, b);
+    }
+}
+
+// Called by the sampler and the emitter, so every update is atomic
+void RecordTickLatency(double late)
+{
+    unsigned int us = late > 0.0 ? (unsigned int)(late * 1e6) : 0;
+    unsigned int bucket = us / 100;
+    if (bucket >= TICK_LATENCY_BUCKETS) bucket = TICK_LATENCY_BUCKETS - 1;
+    g_tickLatency[bucket].fetch_add(1, std::memory_order_relaxed);
+    unsigned int max = g_tickLatencyMaxUs.load(std::memory_order_relaxed);
+    while (us > max && !g_tickLatencyMaxUs.compare_exchange_weak(max, us))
+    {
+    }
+}
+
+void ResetTickLatency()
+{
+    for (int i = 0; i < TICK_LATENCY_BUCKETS; i++) g_tickLatency[i] = 0;
+    g_tickLatencyMaxUs = 0;
+}
+
+// --- Trace Recorder ---
+// Opt-in via trace_file. Opening writes the header and a snapshot of
+// g_config, so (re)loading the config always starts a fresh trace.
+bool OpenTrace(const char* path, double (*now)())
+{
+    CloseTrace();
+    if (!path || !*path) return false;
+
+    std::lock_guard<std::mutex> lock(g_traceLock);
+    FILE* file = fopen(path, "wb");
+    if (!file) return false;
+    TraceHeader header = {TRACE_MAGIC, TRACE_VERSION, sizeof(AppConfig),
+                          sizeof(TraceRecord)};
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(&g_config, sizeof(AppConfig), 1, file);
+    g_traceClock = now;
+    g_traceFile = file;
+    return true;
+}
+
+void CloseTrace()
+{
+    std::lock_guard<std::mutex> lock(g_traceLock);
+    if (!g_traceFile) return;
+    fclose(g_traceFile);
+    g_traceFile = NULL;
+}
+
+void TraceEvent(TraceType type, int a, int b)
+{
+    TraceTriggerEvent(type, 0, a, b);
+}
+
+void TraceTriggerEvent(TraceType type, int binding, int a, int b)
+{
+    if (!g_traceFile) return;
+    std::lock_guard<std::mutex> lock(g_traceLock);
+    if (!g_traceFile) return;
+    TraceAt(type, binding, a, b, g_traceClock());
+    if (type == TRACE_END) fflush(g_traceFile);
+}
+
+// --- Flight Recorder ---
+unsigned long long FlightNow()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - g_flightEpoch)
+        .count();
+}
+
+// Claims a free ring, starting after the last one handed out so the rings
+// of recently finished threads (e.g. the previous gesture) survive longest.
+static void RegisterFlightThread(const char* name)
+{
+    t_flightRegistered = true;
+    unsigned int start = g_flightNextRing.fetch_add(1);
+    for (unsigned int i = 0; i < FLIGHT_MAX_THREADS; i++)
+    {
+        FlightRing* ring = &g_flightRings[(start + i) % FLIGHT_MAX_THREADS];
+        bool expected = false;
+        if (!ring->inUse.compare_exchange_strong(expected, true)) continue;
+
+        // After 256 owners the generation comes round again; records its
+        // earlier holder left in the ring must not take the new name
+        ring->owner++;
+        for (int n = 0; n < FLIGHT_RING_SIZE; n++)
+        {
+            if (ring->records[n].owner == ring->owner)
+                ring->records[n].event = FLIGHT_EVENT_COUNT;
+        }
+        t_flightRing = ring;
+        FlightNameThread(name);
+        return;
+    }
+}
+
+void FlightNameThread(const char* name)
+{
+    if (!t_flightRegistered) RegisterFlightThread(name);
+    FlightRing* ring = t_flightRing;
+    if (!ring) return; // more live threads than rings
+    strncpy(ring->names[ring->owner], name, sizeof(ring->names[0]) - 1);
+}
+
+void FlightReleaseThread()
+{
+    if (t_flightRing) t_flightRing->inUse.store(false);
+    t_flightRing = NULL;
+    t_flightRegistered = false;
+}
+
+void FlightSpan(FlightEvent e, int arg, unsigned long long begin)
+{
+    if (!t_flightRegistered) RegisterFlightThread("thread");
+    FlightRing* ring = t_flightRing;
+    if (!ring) return; // more live threads than rings
+
+    unsigned int head = ring->head.load(std::memory_order_relaxed);
+    FlightRecord* r = &ring->records[head & (FLIGHT_RING_SIZE - 1)];
+    r->begin = begin;
+    r->duration = (unsigned int)(FlightNow() - begin);
+    r->event = (unsigned char)e;
+    r->owner = ring->owner;
+    r->arg = (short)arg;
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+bool DumpFlightTrace(const char* path)
+{
+    static const char* names[FLIGHT_EVENT_COUNT] = {
+        "mouse hook", "keyboard hook", "transition", "sampler tick",
+        "emitter tick", "PostMessage", "SendInput", "uinput write",
+        "overlay", "cursor", "SaveStats", "limit probe"};
+
+    FILE* file = fopen(path, "w");
+    if (!file) return false;
+    fprintf(file, "{\"traceEvents\":[\n");
+
+    bool first = true;
+    bool seen[FLIGHT_MAX_THREADS][256] = {{false}};
+    for (int i = 0; i < FLIGHT_MAX_THREADS; i++)
+    {
+        FlightRing* ring = &g_flightRings[i];
+        unsigned int head = ring->head.load(std::memory_order_acquire);
+        unsigned int count = head < FLIGHT_RING_SIZE ? head : FLIGHT_RING_SIZE;
+        for (unsigned int n = head - count; n != head; n++)
+        {
+            FlightRecord r = ring->records[n & (FLIGHT_RING_SIZE - 1)];
+            if (r.event >= FLIGHT_EVENT_COUNT) continue;
+            seen[i][r.owner] = true;
+            fprintf(file,
+                    "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,"
+                    "\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,"
+                    "\"args\":{\"arg\":%d}}",
+                    first ? "" : ",\n", names[r.event], i * 256 + r.owner,
+                    r.begin / 1000.0, r.duration / 1000.0, r.arg);
+            first = false;
+        }
+    }
+    for (int i = 0; i < FLIGHT_MAX_THREADS; i++)
+    {
+        for (int owner = 0; owner < 256; owner++)
+        {
+            if (!seen[i][owner]) continue;
+            fprintf(file,
+                    "%s{\"name\":\"thread_name\",\"ph\":\"M\","
+                    "\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                    first ? "" : ",\n", i * 256 + owner,
+                    g_flightRings[i].names[owner]);
+            first = false;
+        }
+    }
+    fprintf(file, "\n]}\n");
+    fclose(file);
+    return true;
+}
+
+// --- Control Protocol ---
+// Pipe names are machine-wide; one per logon session keeps instances on a
+// terminal server from answering each other's clients.
+void ControlPipeName(char* name, size_t size, unsigned long session)
+{
+    snprintf(name, size, CONTROL_PIPE_FORMAT, session);
+}
+
+// Fills in the reply header; false if the request is not from a
+// compatible client, in which case the reply goes back as unsupported.
+bool BeginControlReply(const ControlRequest* req, ControlReply* reply)
+{
+    memset(reply, 0, sizeof(ControlReply));
+    reply->magic = CONTROL_MAGIC;
+    reply->version = CONTROL_VERSION;
+    reply->command = req->command;
+    reply->status = CONTROL_UNSUPPORTED;
+    return req->magic == CONTROL_MAGIC && req->version == CONTROL_VERSION;
+}
+
+// Percentiles are the upper edge of their bucket, capped at the maximum
+void FillTickLatency(ControlMetrics* m)
+{
+    unsigned int counts[TICK_LATENCY_BUCKETS];
+    unsigned long long total = 0;
+    for (int i = 0; i < TICK_LATENCY_BUCKETS; i++)
+    {
+        counts[i] = g_tickLatency[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+    double max = g_tickLatencyMaxUs.load() / 1000.0;
+    m->ticks = total;
+    m->tick_late_max_ms = max;
+    m->tick_late_p50_ms = m->tick_late_p99_ms = 0.0;
+    unsigned long long seen = 0;
+    for (int i = 0; i < TICK_LATENCY_BUCKETS && total; i++)
+    {
+        if (!counts[i]) continue;
+        seen += counts[i];
+        double edge = (i + 1) / 10.0;
+        if (edge > max) edge = max;
+        if (!m->tick_late_p50_ms && seen * 2 >= total)
+            m->tick_late_p50_ms = edge;
+        if (seen * 100 >= total * 99)
+        {
+            m->tick_late_p99_ms = edge;
+            break;
+        }
+    }
+}
+
+// --- Stats ---
+void AccumulateStats(int vS, int hS)
+{
+    if (!g_config.fun_stats) return;
+
+    unsigned long long moved = abs(vS) + abs(hS);
+    g_stats.total_pixels += moved;
+    g_stats.session_pixels += moved;
+
+    int logicalVs = g_config.emulate_touchpad_scrolling ? -vS : vS;
+    if (g_config.natural_scrolling) logicalVs = -logicalVs;
+    int logicalHs = g_config.natural_scrolling ? -hS : hS;
+
+    if (logicalVs > 0) g_stats.dir_up += logicalVs;
+    if (logicalVs < 0) g_stats.dir_down += abs(logicalVs);
+    if (logicalHs > 0) g_stats.dir_right += logicalHs;
+    if (logicalHs < 0) g_stats.dir_left += abs(logicalHs);
+}
+
+// stats.ini keeps the [Stats] Key=Value layout of the old
+// Get/WritePrivateProfileString code, which upload_stats.ps1 also edits.
+// The text need not be NUL-terminated, so a memory-mapped file can be
+// parsed in place. False if it holds no stats key at all.
+bool ParseStatsText(const char* text, size_t length, Stats* s)
+{
+    memset(s, 0, sizeof(Stats));
+    bool found = false;
+    const char* end = text + length;
+    while (text < end)
+    {
+        const char* eol = (const char*)memchr(text, '\n', end - text);
+        if (!eol) eol = end;
+        char line[128];
+        size_t n = eol - text;
+        if (n >= sizeof(line)) n = sizeof(line) - 1;
+        memcpy(line, text, n);
+        line[n] = 0;
+        text = eol < end ? eol + 1 : end;
+
+        char* delim = strchr(line, '=');
+        if (!delim) continue;
+
+        *delim = 0;
+        char* key = Trim(line);
+        unsigned long long val = strtoull(Trim(delim + 1), NULL, 10);
+
+        if (!strcmp(key, "TotalPixels"))
+            s->total_pixels = val;
+        else if (!strcmp(key, "Up"))
+            s->dir_up = val;
+        else if (!strcmp(key, "Down"))
+            s->dir_down = val;
+        else if (!strcmp(key, "Left"))
+            s->dir_left = val;
+        else if (!strcmp(key, "Right"))
+            s->dir_right = val;
+        else if (!strcmp(key, "Unuploaded"))
+            s->session_pixels = val;
+        else
+            continue;
+        found = true;
+    }
+    return found;
+}
+
+bool ReadStatsFile(const char* path, Stats* s)
+{
+    memset(s, 0, sizeof(Stats));
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+    char text[4096]; // a handful of lines; anything further is not ours
+    size_t length = fread(text, 1, sizeof(text), file);
+    fclose(file);
+    ParseStatsText(text, length, s);
+    return true;
+}
+
+void MergeStats(Stats* into, const Stats* from)
+{
+    into->total_pixels += from->total_pixels;
+    into->dir_up += from->dir_up;
+    into->dir_down += from->dir_down;
+    into->dir_left += from->dir_left;
+    into->dir_right += from->dir_right;
+    into->session_pixels += from->session_pixels;
+}
+
+bool WriteStatsFile(const char* path, const Stats* s)
+{
+    FILE* file = fopen(path, "w");
+    if (!file) return false;
+    fprintf(file,
+            "[Stats]\nTotalPixels=%llu\nUp=%llu\nDown=%llu\nLeft=%llu\n"
+            "Right=%llu\nUnuploaded=%llu\n",
+            s->total_pixels, s->dir_up, s->dir_down, s->dir_left,
+            s->dir_right, s->session_pixels);
+    fclose(file);
+    return true;
+}
+
+// --- Target Calibration ---
+// Pixels per wheel unit from a vertical scroll bar read before and after a
+// burst of unitsSent, or 0 if the burst cannot tell: too short, the page
+// size changed, the content hit an end or moved the wrong way.
+float MeasureThroughput(const ScrollSnapshot* before,
+                        const ScrollSnapshot* after, int unitsSent)
+{
+    if (abs(unitsSent) < CALIBRATION_MIN_UNITS || before->page <= 0 ||
+        after->page != before->page || before->view_pixels <= 0)
+        return 0.0f;
+    if (after->pos <= after->min || after->pos + after->page - 1 >= after->max)
+        return 0.0f;
+    // Positive wheel deltas scroll towards the top, so pos goes down
+    double moved = (double)(before->pos - after->pos) * before->view_pixels /
+                   before->page;
+    double pixelsPerUnit = moved / unitsSent;
+    return pixelsPerUnit > 0.0 ? (float)pixelsPerUnit : 0.0f;
+}
+
+const Calibration* FindCalibration(const CalibrationCache* c, const char* key)
+{
+    for (int i = 0; i < c->count; i++)
+    {
+        if (!strcmp(c->entries[i].key, key)) return &c->entries[i];
+    }
+    return NULL;
+}
+
+// Averages up to CALIBRATION_SAMPLES gestures. A full cache gives up the
+// target with the fewest.
+void RecordCalibration(CalibrationCache* c, const char* key,
+                       float pixelsPerUnit)
+{
+    Calibration* cal = (Calibration*)FindCalibration(c, key);
+    if (!cal)
+    {
+        if (c->count < MAX_CALIBRATIONS)
+        {
+            cal = &c->entries[c->count++];
+        }
+        else
+        {
+            cal = &c->entries[0];
+            for (int i = 1; i < c->count; i++)
+            {
+                if (c->entries[i].samples < cal->samples)
+                    cal = &c->entries[i];
+            }
+        }
+        memset(cal, 0, sizeof(*cal));
+        strncpy(cal->key, key, sizeof(cal->key) - 1);
+    }
+    int n = cal->samples < CALIBRATION_SAMPLES ? cal->samples
+                                                : CALIBRATION_SAMPLES - 1;
+    cal->pixels_per_unit = (cal->pixels_per_unit * n + pixelsPerUnit) / (n + 1);
+    if (cal->samples < CALIBRATION_SAMPLES) cal->samples++;
+}
+
+// Output scale that gives a target the reference throughput; 1 if unknown
+float CalibratedGain(const Calibration* cal)
+{
+    if (!cal || cal->pixels_per_unit <= 0.0f) return 1.0f;
+    float gain = CALIBRATION_REFERENCE / cal->pixels_per_unit;
+    if (gain < 0.1f) gain = 0.1f;
+    if (gain > 10.0f) gain = 10.0f;
+    return gain;
+}
+
+// calibration.ini: "key=pixels_per_unit samples" under [Calibration].
+// Keys may hold spaces, so the value starts after the last '='.
+bool ReadCalibrationFile(const char* path, CalibrationCache* c)
+{
+    memset(c, 0, sizeof(CalibrationCache));
+    FILE* file = fopen(path, "r");
+    if (!file) return false;
+
+    char line[256];
+    while (fgets(line, sizeof(line), file) && c->count < MAX_CALIBRATIONS)
+    {
+        char* delim = strrchr(line, '=');
+        if (!delim || line[0] == '[') continue;
+
+        *delim = 0;
+        Calibration* cal = &c->entries[c->count];
+        memset(cal, 0, sizeof(*cal));
+        const char* key = Trim(line);
+        size_t length = strlen(key);
+        if (length >= sizeof(cal->key)) length = sizeof(cal->key) - 1;
+        memcpy(cal->key, key, length);
+        cal->key[length] = 0;
+        if (sscanf(delim + 1, "%f %d", &cal->pixels_per_unit,
+                   &cal->samples) == 2 &&
+            cal->key[0] && cal->pixels_per_unit > 0.0f)
+            c->count++;
+    }
+    fclose(file);
+    return true;
+}
+
+bool WriteCalibrationFile(const char* path, const CalibrationCache* c)
+{
+    FILE* file = fopen(path, "w");
+    if (!file) return false;
+    fprintf(file, "[Calibration]\n");
+    for (int i = 0; i < c->count; i++)
+    {
+        fprintf(file, "%s=%.4f %d\n", c->entries[i].key,
+                c->entries[i].pixels_per_unit, c->entries[i].samples);
+    }
+    fclose(file);
+    return true;
+}
+
+// --- Shared Assets ---
+// 64-bit FNV-1a of the file's bytes; 0 if it cannot be read
+unsigned long long HashFile(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file) return 0;
+    unsigned long long hash = 14695981039346656037ULL;
+    unsigned char buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            hash ^= buffer[i];
+            hash *= 1099511628211ULL;
+        }
+    }
+    fclose(file);
+    return hash;
+}
+
+void AssetPackName(char* name, size_t size, unsigned long long source)
+{
+    snprintf(name, size, "assets-v%d-%016llx.bin", ASSET_VERSION, source);
+}
+
+static bool AssetEntryFits(const AssetEntry* e, size_t size)
+{
+    return e->offset % ASSET_ALIGN == 0 && e->offset <= size &&
+           e->size <= size - e->offset;
+}
+
+// The mapped pack as a header, or NULL if it is not a complete pack of
+// this version built from 'source'
+const AssetHeader* CheckAssetPack(const void* data, size_t size,
+                                  unsigned long long source)
+{
+    const AssetHeader* h = (const AssetHeader*)data;
+    if (size < sizeof(AssetHeader) || h->magic != ASSET_MAGIC ||
+        h->version != ASSET_VERSION || h->size != size ||
+        h->source != source || h->indicator_count > ASSET_MAX_INDICATORS)
+        return NULL;
+    for (unsigned int i = 0; i < h->indicator_count; i++)
+    {
+        const AssetEntry* e = &h->indicators[i];
+        if (!AssetEntryFits(e, size) || e->width <= 0 || e->height <= 0 ||
+            e->size != (unsigned long long)e->width * e->height * 4)
+            return NULL;
+    }
+    for (int i = 0; i < ASSET_CURSOR_COUNT; i++)
+    {
+        if (!AssetEntryFits(&h->cursors[i], size)) return NULL;
+    }
+    return h;
+}
+
+// Side of the overlay canvas: the indicator plus room for its outlines
+int IndicatorExtent(float scale)
+{
+    int padding =
+        (int)(g_config.indicator_thickness + g_config.outline_thickness + 5);
+    return (int)((g_config.indicator_size + padding) * 2 * scale + 0.5f);
+}
+
+const AssetEntry* FindIndicator(const AssetHeader* h, int dpi)
+{
+    for (unsigned int i = 0; h && i < h->indicator_count; i++)
+    {
+        if (h->indicators[i].dpi == dpi) return &h->indicators[i];
+    }
+    return NULL;
+}
+
+// --- Trigger Bindings ---
+static int CountBits(int v)
+{
+    int n = 0;
+    for (; v; v &= v - 1) n++;
+    return n;
+}
+
+// "ctrl+rbutton hold 2.5": a chord of modifiers plus one button or key,
+// then optionally the trigger mode, "pan" and a sensitivity (pan scale for
+// pan bindings) for this binding.
+bool ParseTriggerBinding(const char* spec, TriggerBinding* out)
+{
+    char buf[128];
+    strncpy(buf, spec, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = 0;
+    memset(out, 0, sizeof(*out));
+    out->mode = MODE_INHERIT;
+
+    char* chord = strtok(buf, " \t");
+    if (!chord) return false;
+    char* rest = strtok(NULL, "");
+    for (char* part = chord; part;)
+    {
+        char* plus = strchr(part, '+');
+        if (plus) *plus = 0;
+        if (!_stricmp(part, "ctrl") || !_stricmp(part, "control"))
+            out->modifiers |= CHORD_CTRL;
+        else if (!_stricmp(part, "shift"))
+            out->modifiers |= CHORD_SHIFT;
+        else if (!_stricmp(part, "alt"))
+            out->modifiers |= CHORD_ALT;
+        else if (!_stricmp(part, "win"))
+            out->modifiers |= CHORD_WIN;
+        else if (!_stricmp(part, "lbutton"))
+            out->button = TRIGGER_BUTTON_LEFT;
+        else if (!_stricmp(part, "rbutton"))
+            out->button = TRIGGER_BUTTON_RIGHT;
+        else if (!_stricmp(part, "mbutton") || !_stricmp(part, "middle"))
+            out->button = TRIGGER_BUTTON_MIDDLE;
+        else if (!_stricmp(part, "x1") || !_stricmp(part, "xbutton1"))
+            out->button = TRIGGER_BUTTON_X1;
+        else if (!_stricmp(part, "x2") || !_stricmp(part, "xbutton2"))
+            out->button = TRIGGER_BUTTON_X2;
+        else if (toupper((unsigned char)part[0]) == 'F' && isdigit(part[1]))
+            out->vk_code = 0x70 + atoi(part + 1) - 1; // VK_F1..VK_F24
+        else if (isalnum((unsigned char)part[0]) && part[1] == 0)
+            out->vk_code = toupper((unsigned char)part[0]);
+        else
+            out->vk_code = strtol(part, NULL, 0);
+        part = plus ? plus + 1 : NULL;
+    }
+    if (out->button) out->vk_code = 0;
+    if (!out->button && (out->vk_code <= 0 || out->vk_code > 255))
+        return false;
+
+    for (char* opt = rest ? strtok(rest, " \t") : NULL; opt;
+         opt = strtok(NULL, " \t"))
+    {
+        if (!_stricmp(opt, "toggle"))
+            out->mode = MODE_TOGGLE;
+        else if (!_stricmp(opt, "hold"))
+            out->mode = MODE_HOLD;
+        else if (!_stricmp(opt, "pan"))
+            out->pan = 1;
+        else
+            out->sensitivity = (float)atof(opt);
+    }
+    return true;
+}
+
+static void AddTriggerBinding(TriggerTable* t, const TriggerBinding* b)
+{
+    if (t->count == MAX_TRIGGER_BINDINGS) return;
+    t->bindings[t->count] = *b;
+    if (b->mode == MODE_INHERIT)
+        t->bindings[t->count].mode = g_config.trigger_mode;
+    t->count++;
+    if (b->button)
+        t->buttonMask |= b->button;
+    else
+        t->keyBits[(b->vk_code & 255) >> 5] |= 1u << (b->vk_code & 31);
+}
+
+void CompileTriggerTable(TriggerTable* t)
+{
+    memset(t, 0, sizeof(*t));
+    if (g_config.trigger_middle_mouse)
+    {
+        TriggerBinding b = {TRIGGER_BUTTON_MIDDLE, 0, 0, g_config.trigger_mode,
+                            0.0f};
+        AddTriggerBinding(t, &b);
+    }
+    if (g_config.trigger_vk_code > 0 && g_config.trigger_vk_code < 256)
+    {
+        TriggerBinding b = {0, g_config.trigger_vk_code, 0,
+                            g_config.trigger_mode, 0.0f};
+        AddTriggerBinding(t, &b);
+    }
+    for (int i = 0; i < g_config.trigger_count; i++)
+        AddTriggerBinding(t, &g_config.triggers[i]);
+
+    int keys[] = {g_config.cancel_vk_code, g_config.cruise_vk_code,
+                  g_config.cruise_faster_vk_code,
+                  g_config.cruise_slower_vk_code};
+    for (int i = 0; i < 4; i++)
+    {
+        if (keys[i] > 0 && keys[i] < 256)
+            t->keyBits[keys[i] >> 5] |= 1u << (keys[i] & 31);
+    }
+    if (g_activeBinding >= t->count) g_activeBinding = 0;
+}
+
+bool IsTriggerKey(const TriggerTable* t, unsigned int vk)
+{
+    return vk < 256 && ((t->keyBits[vk >> 5] >> (vk & 31)) & 1);
+}
+
+// The most specific binding whose modifiers are all held wins, so
+// ctrl+rbutton and a plain rbutton binding can coexist.
+int FindButtonBinding(const TriggerTable* t, int button, int heldModifiers)
+{
+    int best = -1, bestBits = -1;
+    for (int i = 0; i < t->count; i++)
+    {
+        const TriggerBinding* b = &t->bindings[i];
+        if (b->button != button || (b->modifiers & ~heldModifiers)) continue;
+        if (CountBits(b->modifiers) > bestBits)
+        {
+            best = i;
+            bestBits = CountBits(b->modifiers);
+        }
+    }
+    return best;
+}
+
+int FindKeyBinding(const TriggerTable* t, int vk, int heldModifiers)
+{
+    int best = -1, bestBits = -1;
+    for (int i = 0; i < t->count; i++)
+    {
+        const TriggerBinding* b = &t->bindings[i];
+        if (b->button || b->vk_code != vk || (b->modifiers & ~heldModifiers))
+            continue;
+        if (CountBits(b->modifiers) > bestBits)
+        {
+            best = i;
+            bestBits = CountBits(b->modifiers);
+        }
+    }
+    return best;
+}
+
+// Modifiers may already be up when the key is released
+int FindReleasedKeyBinding(const TriggerTable* t, int vk)
+{
+    const TriggerBinding* active = &t->bindings[g_activeBinding];
+    if (g_activeBinding < t->count && !active->button && active->vk_code == vk)
+        return g_activeBinding;
+    return FindKeyBinding(t, vk, ~0);
+}
+
+// --- Config Loading & Misc ---
+char* Trim(char* str)
+{
+    char* end;
+    while (isspace((unsigned char)*str)) str++;
+    if (*str == 0) return str;
+    end = str + strlen(str) - 1;
+    while (end > str && isspace((unsigned char)*end)) end--;
+    *(end + 1) = 0;
+    return str;
+}
+
+void ParseHexColor(const char* hex, int* r, int* g, int* b, int* a)
+{
+    if (!hex) return;
+    if (*hex == '#') hex++; // Skip '#' if present
+
+    unsigned long val = strtoul(hex, NULL, 16);
+    size_t len = strlen(hex);
+
+    if (len == 6)
+    { // Format: RRGGBB (Assume alpha = 255)
+        *r = (val >> 16) & 0xFF;
+        *g = (val >> 8) & 0xFF;
+        *b = val & 0xFF;
+        *a = 255;
+    }
+    else if (len == 8)
+    { // Format: RRGGBBAA
+        *r = (val >> 24) & 0xFF;
+        *g = (val >> 16) & 0xFF;
+        *b = (val >> 8) & 0xFF;
+        *a = val & 0xFF;
+    }
+}
+
+void LoadConfig(const char* filename)
+{
+    ResetTickLatency(); // the metrics describe the settings in effect
+    FILE* file = fopen(filename, "r");
+    if (!file)
+    {
+        CompileTriggerTable(&g_triggers);
+        ScaleMotionProfile(&g_motion, g_motion.dpi);
+        return;
+    }
+
+    char line[256];
+    g_config.trigger_count = 0; // the file lists all of them
+    while (fgets(line, sizeof(line), file))
+    {
+        if (line[0] == '#' || line[0] == '\n') continue;
+        char* delim = strchr(line, '=');
+        if (!delim) continue;
+
+        *delim = 0;
+        char* key = Trim(line);
+        char* val = Trim(delim + 1);
+
+        if (!strcmp(key, "min_scroll"))
+            g_config.min_scroll = atoi(val);
+        else if (!strcmp(key, "max_scroll"))
+            g_config.max_scroll = atoi(val);
+        else if (!strcmp(key, "sensitivity"))
+            g_config.sensitivity = (float)atof(val);
+        else if (!strcmp(key, "ramp_exponent"))
+            g_config.ramp_exponent = (float)atof(val);
+        else if (!strcmp(key, "update_frequency"))
+            g_config.update_frequency = atoi(val);
+        else if (!strcmp(key, "trigger_middle_mouse"))
+            g_config.trigger_middle_mouse = atoi(val);
+        else if (!strcmp(key, "trigger_vk_code"))
+            g_config.trigger_vk_code = strtol(val, NULL, 0);
+        else if (!strcmp(key, "cancel_vk_code"))
+            g_config.cancel_vk_code = strtol(val, NULL, 0);
+        else if (!strcmp(key, "cruise_vk_code"))
+            g_config.cruise_vk_code = strtol(val, NULL, 0);
+        else if (!strcmp(key, "cruise_faster_vk_code"))
+            g_config.cruise_faster_vk_code = strtol(val, NULL, 0);
+        else if (!strcmp(key, "cruise_slower_vk_code"))
+            g_config.cruise_slower_vk_code = strtol(val, NULL, 0);
+        else if (!strcmp(key, "cruise_step"))
+            g_config.cruise_step = (float)atof(val);
+        else if (!strcmp(key, "trigger"))
+        {
+            TriggerBinding* b = &g_config.triggers[g_config.trigger_count];
+            if (g_config.trigger_count < MAX_TRIGGER_BINDINGS &&
+                ParseTriggerBinding(val, b))
+                g_config.trigger_count++;
+        }
+        else if (!strcmp(key, "emulate_touchpad_scrolling"))
+            g_config.emulate_touchpad_scrolling = atoi(val);
+        else if (!strcmp(key, "middle_mouse_passthrough"))
+            g_config.middle_mouse_passthrough = atoi(val);
+        else if (!strcmp(key, "keyboard_passthrough"))
+            g_config.keyboard_passthrough = atoi(val);
+        else if (!strcmp(key, "drag_threshold"))
+            g_config.drag_threshold = atoi(val);
+        else if (!strcmp(key, "dead_zone"))
+            g_config.dead_zone = atoi(val);
+        else if (!strcmp(key, "axis_lock_threshold"))
+            g_config.axis_lock_threshold = atoi(val);
+        else if (!strcmp(key, "output_frequency"))
+            g_config.output_frequency = atoi(val);
+        else if (!strcmp(key, "output_vsync"))
+            g_config.output_vsync = atoi(val);
+        else if (!strcmp(key, "max_pending_messages"))
+            g_config.max_pending_messages = atoi(val);
+        else if (!strcmp(key, "scroll_limit_probe_ms"))
+            g_config.scroll_limit_probe_ms = atoi(val);
+        else if (!strcmp(key, "dpi_scaling"))
+            g_config.dpi_scaling = atoi(val);
+        else if (!strcmp(key, "pan_scale"))
+            g_config.pan_scale = (float)atof(val);
+        else if (!strcmp(key, "calibrate_targets"))
+            g_config.calibrate_targets = atoi(val);
+        else if (!strcmp(key, "realtime_scheduling"))
+            g_config.realtime_scheduling = atoi(val);
+        else if (!strcmp(key, "realtime_core"))
+            g_config.realtime_core = atoi(val);
+        else if (!strcmp(key, "idle_trim_seconds"))
+            g_config.idle_trim_seconds = atoi(val);
+        else if (!strcmp(key, "trace_file"))
+        {
+            strncpy(g_config.trace_file, val, sizeof(g_config.trace_file) - 1);
+            g_config.trace_file[sizeof(g_config.trace_file) - 1] = 0;
+        }
+        else if (!strcmp(key, "shared_assets"))
+        {
+            strncpy(g_config.shared_assets, val,
+                    sizeof(g_config.shared_assets) - 1);
+            g_config.shared_assets[sizeof(g_config.shared_assets) - 1] = 0;
+        }
+        else if (!strcmp(key, "use_send_input_api"))
+            g_config.use_send_input_api = atoi(val);
+        else if (!strcmp(key, "show_indicator"))
+            g_config.show_indicator = atoi(val);
+        else if (!strcmp(key, "indicator_size"))
+            g_config.indicator_size = atoi(val);
+        else if (!strcmp(key, "indicator_cross_thickness"))
+            g_config.indicator_cross_thickness = atoi(val);
+        else if (!strcmp(key, "indicator_thickness"))
+            g_config.indicator_thickness = (float)atof(val);
+        else if (!strcmp(key, "indicator_filled"))
+            g_config.indicator_filled = atoi(val);
+        else if (!strcmp(key, "fun_stats"))
+            g_config.fun_stats = atoi(val);
+        else if (!strcmp(key, "natural_scrolling"))
+            g_config.natural_scrolling = atoi(val);
+        else if (!strcmp(key, "show_outline"))
+            g_config.show_outline = atoi(val);
+        else if (!strcmp(key, "outline_thickness"))
+            g_config.outline_thickness = (float)atof(val);
+        else if (!strcmp(key, "indicator_color"))
+        {
+            ParseHexColor(
+                val, &g_config.indicator_color_r, &g_config.indicator_color_g,
+                &g_config.indicator_color_b, &g_config.indicator_color_a);
+        }
+        else if (!strcmp(key, "outline_color"))
+        {
+            ParseHexColor(val, &g_config.outline_color_r,
+                          &g_config.outline_color_g, &g_config.outline_color_b,
+                          &g_config.outline_color_a);
+        }
+        else if (!strcmp(key, "trigger_mode"))
+        {
+            g_config.trigger_mode =
+                (_stricmp(val, "hold") == 0) ? MODE_HOLD : MODE_TOGGLE;
+        }
+        else if (!strcmp(key, "dead_zone_shape"))
+        {
+            if (_stricmp(val, "square") == 0)
+                g_config.dead_zone_shape = SHAPE_SQUARE;
+            else
+                g_config.dead_zone_shape = SHAPE_CIRCLE;
+        }
+        else if (!strcmp(key, "input_filter"))
+        {
+            if (_stricmp(val, "one_euro") == 0)
+                g_config.input_filter = FILTER_ONE_EURO;
+            else if (_stricmp(val, "ema") == 0)
+                g_config.input_filter = FILTER_EMA;
+            else
+                g_config.input_filter = FILTER_NONE;
+        }
+        else if (!strcmp(key, "filter_ema_alpha"))
+            g_config.filter_ema_alpha = (float)atof(val);
+        else if (!strcmp(key, "filter_min_cutoff"))
+            g_config.filter_min_cutoff = (float)atof(val);
+        else if (!strcmp(key, "filter_beta"))
+            g_config.filter_beta = (float)atof(val);
+        else if (!strcmp(key, "filter_d_cutoff"))
+            g_config.filter_d_cutoff = (float)atof(val);
+        else if (!strcmp(key, "indicator_shape"))
+        {
+            if (_stricmp(val, "square") == 0)
+                g_config.indicator_shape = SHAPE_SQUARE;
+            else if (_stricmp(val, "cross") == 0)
+                g_config.indicator_shape = SHAPE_CROSS;
+            else
+                g_config.indicator_shape = SHAPE_CIRCLE;
+        }
+    }
+    fclose(file);
+    CompileTriggerTable(&g_triggers);
+    ScaleMotionProfile(&g_motion, g_motion.dpi);
+}
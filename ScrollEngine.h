@@ -0,0 +1,568 @@
+// Platform-neutral scroll engine: config, stats, trigger state machine and
+// the per-tick scroll kernel. Nothing in here may include an OS header;
+// WinAutoScroll.cpp (Win32) and LinuxAutoScroll.cpp (evdev/uinput) supply
+// input capture, output and cursor feedback through ScrollBackend.
+#pragma once
+
+#include <stddef.h>
+
+#include <atomic>
+
+#ifndef _WIN32
+#include <strings.h>
+#define _stricmp strcasecmp
+#endif
+
+// --- Enums ---
+typedef enum
+{
+    STATE_IDLE,
+    STATE_PRIMED,
+    STATE_SCROLLING,
+    STATE_STOPPING
+} ScrollState;
+typedef enum
+{
+    SHAPE_CIRCLE,
+    SHAPE_SQUARE,
+    SHAPE_CROSS
+} Shape;
+typedef enum
+{
+    MODE_TOGGLE,
+    MODE_HOLD,
+    MODE_INHERIT // a binding without its own: trigger_mode, when compiled
+} TriggerMode;
+typedef enum
+{
+    CURSOR_NONE,
+    CURSOR_ALL,
+    CURSOR_NS,
+    CURSOR_WE,
+    CURSOR_NWSE,
+    CURSOR_NESW
+} ScrollCursorType;
+typedef enum
+{
+    FILTER_NONE,
+    FILTER_EMA,
+    FILTER_ONE_EURO
+} InputFilter;
+
+// Trigger buttons, as TriggerBinding.button and TriggerTable.buttonMask bits
+#define TRIGGER_BUTTON_LEFT 0x01
+#define TRIGGER_BUTTON_RIGHT 0x02
+#define TRIGGER_BUTTON_MIDDLE 0x04
+#define TRIGGER_BUTTON_X1 0x08
+#define TRIGGER_BUTTON_X2 0x10
+
+// Modifier keys a binding needs held
+#define CHORD_CTRL 0x01
+#define CHORD_SHIFT 0x02
+#define CHORD_ALT 0x04
+#define CHORD_WIN 0x08
+
+#define MAX_TRIGGER_BINDINGS 16
+
+typedef struct
+{
+    int button;        // one TRIGGER_BUTTON_* bit, 0 for a key binding
+    int vk_code;       // Virtual-Key code of a key binding
+    int modifiers;     // CHORD_* bits
+    TriggerMode mode;
+    float sensitivity; // per-binding profile, 0 = global sensitivity (or
+                       // pan_scale for a pan binding)
+    int pan;           // grab-pan: the content follows the pointer 1:1
+} TriggerBinding;
+
+// Trigger buttons a backend has swallowed and owes a release for. Only the
+// press that starts a gesture is held; buttons pressed while it runs are
+// swallowed press and release as a pair, so they cannot steal its release.
+typedef struct
+{
+    int button, binding;    // the gesture's press, button 0 = none
+    unsigned int swallowed; // TRIGGER_BUTTON_* bits pressed mid-gesture
+} HeldButtons;
+
+// Drag threshold as an input hook checks it, so a primed trigger costs the
+// event loop one message instead of one per pointer move. Armed by the
+// press; exactly one move past the threshold crosses it.
+typedef struct
+{
+    std::atomic<unsigned long long> prime; // press point, x high, y low
+    std::atomic<bool> armed;
+    int threshold;
+} DragGate;
+
+// What a backend has to do in response to a trigger event
+typedef enum
+{
+    ACTION_NONE,
+    ACTION_START,
+    ACTION_STOP,
+    ACTION_CLICK // replay the swallowed middle click
+} TriggerAction;
+
+// --- Config & Stats ---
+typedef struct
+{
+    int min_scroll, max_scroll;
+    float sensitivity, ramp_exponent;
+    int update_frequency;
+    int trigger_vk_code, trigger_middle_mouse, emulate_touchpad_scrolling;
+    TriggerMode trigger_mode;
+    int middle_mouse_passthrough, keyboard_passthrough, drag_threshold;
+    Shape dead_zone_shape;
+    int dead_zone;
+    int axis_lock_threshold;
+    int use_send_input_api;
+    int show_indicator;
+    Shape indicator_shape;
+    int indicator_size, indicator_cross_thickness;
+    int indicator_color_r, indicator_color_g, indicator_color_b,
+        indicator_color_a;
+    float indicator_thickness;
+    int indicator_filled;
+    int fun_stats;
+    int natural_scrolling;
+    int show_outline;
+    float outline_thickness;
+    int outline_color_r, outline_color_g, outline_color_b, outline_color_a;
+    InputFilter input_filter;
+    float filter_ema_alpha;
+    float filter_min_cutoff, filter_beta, filter_d_cutoff;
+    int output_frequency, output_vsync;
+    int max_pending_messages;
+    int scroll_limit_probe_ms;
+    int idle_trim_seconds;
+    TriggerBinding triggers[MAX_TRIGGER_BINDINGS]; // 'trigger =' lines
+    int trigger_count;
+    int cancel_vk_code;
+    int cruise_vk_code, cruise_faster_vk_code, cruise_slower_vk_code;
+    float cruise_step; // percent per nudge
+    int dpi_scaling; // pixel settings are at 96 DPI, scaled per monitor
+    float pan_scale; // wheel units per pixel of grab-pan, at 96 DPI
+    int calibrate_targets;
+    int realtime_scheduling, realtime_core; // scroll threads; core -1 = any
+    char shared_assets[260]; // directory of the shared asset pack
+    char trace_file[260];
+} AppConfig;
+
+// Every binding in effect (legacy keys first, then 'trigger =' lines),
+// compiled at config load so hooks can drop unrelated input with one bit
+// test.
+typedef struct
+{
+    TriggerBinding bindings[MAX_TRIGGER_BINDINGS];
+    int count;
+    unsigned int keyBits[8]; // 256-bit VK set: trigger, cancel, cruise keys
+    unsigned int buttonMask; // TRIGGER_BUTTON_* bits of all button bindings
+} TriggerTable;
+
+// Pixel thresholds and curve input of one monitor, pre-scaled from the
+// config's 96-DPI values so a gesture feels the same at any scaling.
+typedef struct
+{
+    int dpi;
+    int dead_zone, drag_threshold, axis_lock_threshold;
+    float input_scale; // physical pixels to 96-DPI pixels, for the curve
+} MotionProfile;
+
+typedef struct
+{
+    unsigned long long total_pixels;
+    unsigned long long dir_up, dir_down, dir_left, dir_right;
+    unsigned long long session_pixels;
+} Stats;
+
+typedef struct
+{
+    int x, y;
+} ScrollPoint;
+
+// --- Target Calibration ---
+// Pixels one wheel unit moves in a typical browser (100 per notch). The
+// curve and pan_scale are tuned for it; calibrated targets are scaled to
+// match.
+#define CALIBRATION_REFERENCE (100.0f / 120.0f)
+#define CALIBRATION_SAMPLES 5      // gestures measured per target
+#define CALIBRATION_MIN_UNITS 360  // smallest burst worth measuring
+#define MAX_CALIBRATIONS 64
+
+// Vertical scroll bar of a target, with the height of what it scrolls
+typedef struct
+{
+    int pos, page, min, max; // SCROLLINFO units
+    int view_pixels;
+} ScrollSnapshot;
+
+typedef struct
+{
+    char key[96];          // "process.exe|WindowClass"
+    float pixels_per_unit; // measured throughput
+    int samples;
+} Calibration;
+
+typedef struct
+{
+    Calibration entries[MAX_CALIBRATIONS];
+    int count;
+} CalibrationCache;
+
+// Per-axis smoothing state, owned by the scroll worker
+typedef struct
+{
+    bool primed;
+    double value, velocity;
+} AxisFilter;
+
+// Latest target velocity (wheel units/sec) handed from the sampling stage
+// to the emission stage. Packed so it can be swapped in one atomic op.
+typedef union
+{
+    unsigned long long bits;
+    struct
+    {
+        float v, h;
+    } rate;
+} VelocityMailbox;
+
+// Per-gesture state of the sampling stage
+typedef struct
+{
+    AxisFilter filterX, filterY;
+    ScrollCursorType cursor;
+    double last; // time of the previous tick, < 0 before the first one
+    bool decoupled;
+    unsigned long long cruise; // cruise rate seen last tick, 0 = off
+    double cruiseAccV, cruiseAccH;
+    bool pan;       // grab-pan gesture: emits pointer motion directly
+    int panX, panY; // pointer at the previous tick
+    double panAccV, panAccH;
+} SamplerState;
+
+// Interpolation state of the emission stage
+typedef struct
+{
+    double curV, curH; // interpolated velocity
+    double accV, accH; // sub-unit remainder carried across ticks
+    double last;       // time of the previous tick, < 0 before the first one
+} EmitterState;
+
+// Result of one pass of the scroll kernel
+typedef struct
+{
+    bool active; // outside the dead zone
+    int vS, hS;  // signed wheel deltas, ready to emit
+    ScrollCursorType cursor;
+} ScrollTick;
+
+// --- Wheel Flow Control ---
+// Output to a target that can acknowledge a message once it has handled
+// it (Win32 messages to the anchor window). Deltas are merged while the
+// target is behind. A tick goes out as at most WHEEL_TICK_MESSAGES calls:
+// one message per axis, the acknowledgement riding on one of them.
+#define WHEEL_TICK_MESSAGES 2
+// Smoothed round trip, in emit intervals, past which the target counts as
+// slow and only one message is kept in flight
+#define WHEEL_SLOW_TARGET_TICKS 1.5
+// Emit intervals beyond the smoothed round trip after which an
+// acknowledgement counts as overdue and the target is checked for a hang
+#define WHEEL_OVERDUE_TICKS 2
+
+typedef struct
+{
+    int outstanding;        // messages not acknowledged yet
+    int pendingV, pendingH; // deltas held back while the target is behind
+    double rtt;             // smoothed acknowledgement round trip, seconds
+    double waiting;         // since when an acknowledgement is awaited
+} WheelFlow;
+
+typedef struct
+{
+    int horizontal; // WM_MOUSEHWHEEL rather than WM_MOUSEWHEEL
+    int delta;
+    int ack;        // send so that the target acknowledges it
+} WheelMessage;
+
+// --- Backend Interface ---
+typedef struct
+{
+    void (*GetPointer)(int* x, int* y);        // input capture
+    void (*EmitScroll)(int vS, int hS);        // output (may be 0, 0)
+    void (*SetFeedback)(ScrollCursorType t);   // cursor feedback
+    double (*Now)();                           // monotonic seconds
+    void (*WaitSample)(int ms);                // sampling stage cadence
+    void (*WaitOutput)(int ms);                // emission stage cadence
+    void (*WaitInput)(int ms);                 // grab-pan: pointer moved
+} ScrollBackend;
+
+// --- Trace Format ---
+// Binary trace: TraceHeader, the AppConfig in effect, then fixed-size
+// TraceRecords. Replaying the same file through the engine must
+// reproduce the TRACE_EMIT records bit for bit.
+#define TRACE_MAGIC 0x54534157 // "WAST"
+#define TRACE_VERSION 5
+
+typedef enum
+{
+    TRACE_BUTTON_DOWN = 1, // a, b = pointer, binding
+    TRACE_BUTTON_UP,       // binding
+    TRACE_PRIMED_MOVE,     // a, b = pointer
+    TRACE_KEY_DOWN,        // binding
+    TRACE_KEY_UP,          // binding
+    TRACE_CANCEL,
+    TRACE_BEGIN,           // a, b = anchor
+    TRACE_END,
+    TRACE_SAMPLE,          // a, b = pointer, time = sampler tick
+    TRACE_EMITTER_TICK,    // time = emitter tick
+    TRACE_EMIT,            // a, b = vS, hS, time = tick that produced it
+    TRACE_MOTION,          // a = dpi of the selected motion profile
+    TRACE_CRUISE           // a, b = locked rate as VelocityMailbox halves
+} TraceType;
+
+typedef struct
+{
+    unsigned int magic, version;
+    unsigned int configSize, recordSize;
+} TraceHeader;
+
+typedef struct
+{
+    unsigned int type;
+    int a, b;
+    int binding; // trigger binding index of trigger events
+    double time;
+} TraceRecord;
+
+// --- Flight Recorder ---
+// Always-on, fixed-size ring of timing spans per thread, dumped on demand
+// as Chrome/Perfetto trace JSON.
+typedef enum
+{
+    FLIGHT_HOOK_MOUSE,
+    FLIGHT_HOOK_KEYBOARD,
+    FLIGHT_TRANSITION,
+    FLIGHT_SAMPLER_TICK,
+    FLIGHT_EMITTER_TICK,
+    FLIGHT_POST_MESSAGE,
+    FLIGHT_SEND_INPUT,
+    FLIGHT_UINPUT_WRITE,
+    FLIGHT_OVERLAY,
+    FLIGHT_CURSOR,
+    FLIGHT_SAVE_STATS,
+    FLIGHT_LIMIT_PROBE,
+    FLIGHT_EVENT_COUNT
+} FlightEvent;
+
+// --- Control Protocol ---
+// Local control channel of a running instance: a named pipe per logon
+// session on Windows, a Unix socket on Linux. One ControlRequest in, one
+// ControlReply out per connection; ScrollControl.cpp is the command-line
+// client.
+#define CONTROL_MAGIC 0x43534157 // "WASC"
+#define CONTROL_VERSION 4
+#define CONTROL_PIPE_FORMAT "\\\\.\\pipe\\WinAutoScroll-%lu" // session ID
+#define CONTROL_SOCKET_NAME "linuxautoscroll.sock" // in $XDG_RUNTIME_DIR
+
+typedef enum
+{
+    CONTROL_PAUSE = 1,
+    CONTROL_RESUME,
+    CONTROL_RELOAD,
+    CONTROL_STATS,
+    CONTROL_METRICS,
+    CONTROL_DUMP_TRACE
+} ControlCommand;
+
+typedef enum
+{
+    CONTROL_OK,
+    CONTROL_FAILED,
+    CONTROL_UNSUPPORTED
+} ControlStatus;
+
+typedef struct
+{
+    unsigned int magic, version;
+    unsigned int command; // ControlCommand
+} ControlRequest;
+
+typedef struct
+{
+    int paused;
+    int scroll_state; // ScrollState
+    double startup_ms;
+    unsigned long long working_set, peak_working_set; // bytes
+    unsigned long long private_bytes;                 // bytes not shareable
+    unsigned long long feedback_updates;              // overlay/cursor
+    double feedback_latency_avg_ms, feedback_latency_max_ms;
+    int realtime; // last scroll thread: 1 raised, 0 normal, -1 not allowed
+    unsigned long long ticks; // scroll ticks timed since the config loaded
+    double tick_late_p50_ms, tick_late_p99_ms, tick_late_max_ms;
+    // Calls that injected the last gesture's scrolling: SendInput on
+    // Windows (use_send_input_api, one per tick when batched), uinput
+    // writes on Linux
+    unsigned long long gesture_input_calls;
+} ControlMetrics;
+
+// Working set of an idle instance the README promises; 'scrollctl metrics
+// --budget' and the tray's Resource Usage check against it
+#define MEMORY_BUDGET_BYTES (1536ULL * 1024)
+
+typedef struct
+{
+    unsigned int magic, version;
+    unsigned int command, status; // ControlCommand, ControlStatus
+    Stats stats;                  // CONTROL_STATS
+    ControlMetrics metrics;       // CONTROL_METRICS
+    char path[260];               // CONTROL_DUMP_TRACE: file written
+} ControlReply;
+
+// --- Shared Assets ---
+// Read-only pack shared by every instance on a machine (terminal servers
+// run one per session): the indicator pre-rendered per DPI and the scroll
+// cursors. One instance builds it, the others map it. The file name holds
+// ASSET_VERSION and a hash of the config it was drawn from, so a pack is
+// never rewritten once published.
+#define ASSET_MAGIC 0x50534157 // "WASP"
+#define ASSET_VERSION 1
+#define ASSET_ALIGN 16 // entry offsets, so pixel rows are read aligned
+#define ASSET_MAX_INDICATORS 8
+#define ASSET_CURSOR_COUNT 4 // CURSOR_NS .. CURSOR_NESW
+
+typedef struct
+{
+    unsigned int offset, size; // bytes from the start of the file, 0 = none
+    int width, height, dpi;    // indicators only
+} AssetEntry;
+
+// Indicators are premultiplied BGRA, top-down. Cursors are icon resource
+// data: the hotspot as two 16-bit values, then the image.
+typedef struct
+{
+    unsigned int magic, version;
+    unsigned int size; // whole file
+    unsigned int indicator_count;
+    unsigned long long source; // HashFile of the config
+    AssetEntry indicators[ASSET_MAX_INDICATORS];
+    AssetEntry cursors[ASSET_CURSOR_COUNT];
+} AssetHeader;
+
+// --- Shared State ---
+extern AppConfig g_config;
+extern Stats g_stats;
+extern volatile ScrollState g_scrollState;
+extern ScrollPoint g_startScrollPos, g_primeStartPos;
+extern std::atomic<unsigned long long> g_targetVelocity;
+extern std::atomic<unsigned long long> g_cruiseVelocity; // 0 = not cruising
+extern TriggerTable g_triggers;
+extern volatile int g_activeBinding; // binding that owns the current gesture
+extern MotionProfile g_motion;        // profile of the gesture's monitor
+
+// --- Config & Stats ---
+void LoadConfig(const char* filename);
+bool ParseStatsText(const char* text, size_t length, Stats* s);
+bool ReadStatsFile(const char* path, Stats* s);
+void MergeStats(Stats* into, const Stats* from);
+bool WriteStatsFile(const char* path, const Stats* s);
+void AccumulateStats(int vS, int hS);
+void ParseHexColor(const char* hex, int* r, int* g, int* b, int* a);
+char* Trim(char* str);
+
+// --- Target Calibration ---
+float MeasureThroughput(const ScrollSnapshot* before,
+                        const ScrollSnapshot* after, int unitsSent);
+const Calibration* FindCalibration(const CalibrationCache* c,
+                                   const char* key);
+void RecordCalibration(CalibrationCache* c, const char* key,
+                       float pixelsPerUnit);
+float CalibratedGain(const Calibration* cal);
+bool ReadCalibrationFile(const char* path, CalibrationCache* c);
+bool WriteCalibrationFile(const char* path, const CalibrationCache* c);
+
+// --- Trigger Bindings ---
+bool ParseTriggerBinding(const char* spec, TriggerBinding* out);
+void CompileTriggerTable(TriggerTable* t);
+bool IsTriggerKey(const TriggerTable* t, unsigned int vk);
+int FindButtonBinding(const TriggerTable* t, int button, int heldModifiers);
+int FindKeyBinding(const TriggerTable* t, int vk, int heldModifiers);
+int FindReleasedKeyBinding(const TriggerTable* t, int vk);
+
+// --- Motion Profiles ---
+void ScaleMotionProfile(MotionProfile* m, int dpi);
+void SelectMotionProfile(const MotionProfile* m);
+
+// --- Trigger State Machine ---
+TriggerAction OnTriggerButtonDown(int binding, int x, int y);
+TriggerAction OnTriggerButtonUp(int binding);
+bool PastDragThreshold(int x, int y, int primeX, int primeY, int threshold);
+void ArmDragGate(DragGate* g, int x, int y, int threshold);
+void DisarmDragGate(DragGate* g);
+bool CrossDragGate(DragGate* g, int x, int y);
+TriggerAction OnPrimedMove(int x, int y);
+TriggerAction OnTriggerKeyDown(int binding);
+TriggerAction OnTriggerKeyUp(int binding);
+TriggerAction OnCancel();
+bool BeginScrolling(int x, int y);
+bool EndScrolling();
+bool IsPanGesture();
+void PressHeldButton(HeldButtons* h, int button, int binding);
+bool ReleaseHeldButton(HeldButtons* h, int button, int* binding);
+
+// --- Cruise ---
+void OnCruiseToggle();
+void OnCruiseNudge(int direction); // +1 faster, -1 slower
+bool IsCruising();
+
+// --- Scroll Kernel ---
+int CalculateScrollAmount(int delta, bool isTouchpad);
+double FilterOffset(AxisFilter* f, double raw, double dt);
+void ComputeScrollTick(int dx, int dy, ScrollTick* out);
+void ComputePanTick(SamplerState* s, int x, int y, ScrollTick* out);
+void PublishVelocity(float v, float h);
+void StepEmitter(EmitterState* e, double dt, int* vS, int* hS);
+int SampleFrequency();
+
+// --- Wheel Flow Control ---
+int PlanWheelMessages(WheelFlow* f, int maxOutstanding, double now,
+                      WheelMessage* out);
+// rtt < 0: never delivered
+void AckWheelMessage(WheelFlow* f, double rtt, double now);
+bool WheelAckOverdue(const WheelFlow* f, double now);
+void ResetWheelFlow(WheelFlow* f);
+
+// --- Workers (run on a backend-created thread until scrolling stops) ---
+void BeginSampler(SamplerState* s, bool decoupled);
+void SamplerTick(SamplerState* s, const ScrollBackend* b);
+void EmitterTick(EmitterState* e, const ScrollBackend* b);
+void RunSampler(const ScrollBackend* b, bool decoupled);
+void RunEmitter(const ScrollBackend* b);
+void RecordTickLatency(double late); // seconds past the requested wake-up
+void ResetTickLatency();
+
+// --- Trace Recorder ---
+bool OpenTrace(const char* path, double (*now)());
+void CloseTrace();
+void TraceEvent(TraceType type, int a, int b);
+void TraceTriggerEvent(TraceType type, int binding, int a, int b);
+
+// --- Flight Recorder ---
+unsigned long long FlightNow(); // ns since process start
+void FlightSpan(FlightEvent e, int arg, unsigned long long begin);
+void FlightNameThread(const char* name);
+void FlightReleaseThread();
+bool DumpFlightTrace(const char* path);
+
+// --- Control Protocol ---
+void ControlPipeName(char* name, size_t size, unsigned long session);
+bool BeginControlReply(const ControlRequest* req, ControlReply* reply);
+void FillTickLatency(ControlMetrics* m);
+
+// --- Shared Assets ---
+unsigned long long HashFile(const char* path);
+void AssetPackName(char* name, size_t size, unsigned long long source);
+const AssetHeader* CheckAssetPack(const void* data, size_t size,
+                                  unsigned long long source);
+const AssetEntry* FindIndicator(const AssetHeader* h, int dpi);
+int IndicatorExtent(float scale); // overlay canvas side at a DPI scale
@@ -0,0 +1,199 @@
+// Linux only: measures how late the scroll engine's sampler wakes up while
+// every core is busy, once per scheduling mode, to show what
+// realtime_scheduling buys on a loaded machine. The sampler runs the real
+// RunSampler loop against a backend that only keeps time, and the results
+// are the same tick latency percentiles 'scrollctl metrics' reports.
+//   scrolljitter [--seconds s] [--hz n] [--load threads] [--config ini]
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "ScrollEngine.h"
+
+// Same priority LinuxAutoScroll's EnterRealtime asks for
+#define JITTER_RT_PRIORITY 10
+#define MAX_LOAD_THREADS 1024
+
+// --- Modes ---
+typedef enum
+{
+    JITTER_NORMAL,   // SCHED_OTHER, like realtime_scheduling = 0
+    JITTER_REALTIME, // SCHED_RR, realtime_scheduling = 1
+    JITTER_PINNED,   // SCHED_RR on one core, realtime_core = last core
+    JITTER_MODE_COUNT
+} JitterMode;
+
+const char* g_modeNames[JITTER_MODE_COUNT] = {"normal", "realtime",
+                                              "realtime_pinned"};
+
+// --- Timing Backend ---
+// Holds the pointer off the anchor so every tick scrolls; nothing is sent
+void JitterGetPointer(int* x, int* y)
+{
+    *x = 0;
+    *y = 200;
+}
+
+void JitterEmitScroll(int vS, int hS)
+{
+}
+
+void JitterSetFeedback(ScrollCursorType t)
+{
+}
+
+double JitterNow()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+void JitterWait(int ms)
+{
+    struct timespec ts = {ms / 1000, (long)(ms % 1000) * 1000000L};
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+    {
+    }
+}
+
+const ScrollBackend g_jitterBackend = {JitterGetPointer, JitterEmitScroll,
+                                       JitterSetFeedback, JitterNow,
+                                       JitterWait,        JitterWait,
+                                       JitterWait};
+
+// --- Load ---
+std::atomic<bool> g_loadRunning(false);
+
+void SpinLoad()
+{
+    volatile double x = 1.0;
+    while (g_loadRunning.load(std::memory_order_relaxed))
+        x = x * 1.0000001 + 1e-9;
+}
+
+// --- Measurement ---
+typedef struct
+{
+    JitterMode mode;
+    int error; // errno of the scheduling request, 0 if it applied
+} SamplerRun;
+
+void EnterMode(SamplerRun* run)
+{
+    run->error = 0;
+    if (run->mode == JITTER_NORMAL) return;
+    struct sched_param param;
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = JITTER_RT_PRIORITY;
+    run->error = pthread_setschedparam(pthread_self(), SCHED_RR, &param);
+    if (run->error || run->mode != JITTER_PINNED) return;
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(std::thread::hardware_concurrency() - 1, &cpus);
+    run->error = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+}
+
+void SamplerThread(SamplerRun* run)
+{
+    EnterMode(run);
+    if (run->error == 0) RunSampler(&g_jitterBackend, false);
+    FlightReleaseThread();
+}
+
+// One gesture of the given length; false if the mode is not allowed
+bool MeasureMode(JitterMode mode, double seconds, ControlMetrics* m)
+{
+    g_scrollState = STATE_IDLE;
+    OnTriggerButtonDown(0, 0, 0);
+    OnPrimedMove(30, 40);
+    BeginScrolling(0, 0);
+    ResetTickLatency();
+
+    SamplerRun run = {mode, 0};
+    std::thread sampler(SamplerThread, &run);
+    struct timespec ts = {(time_t)seconds,
+                          (long)((seconds - (time_t)seconds) * 1e9)};
+    nanosleep(&ts, NULL);
+    OnTriggerButtonUp(0);
+    EndScrolling();
+    sampler.join();
+    g_scrollState = STATE_IDLE;
+
+    memset(m, 0, sizeof(*m));
+    FillTickLatency(m);
+    if (run.error)
+    {
+        printf("%-16s unavailable (%s)\n", g_modeNames[mode],
+               strerror(run.error));
+        return false;
+    }
+    printf("%-16s %8llu %8.1f %8.1f %8.1f\n", g_modeNames[mode], m->ticks,
+           m->tick_late_p50_ms, m->tick_late_p99_ms, m->tick_late_max_ms);
+    return true;
+}
+
+// --- Entry Point ---
+int main(int argc, char** argv)
+{
+    double seconds = 5.0;
+    int hz = 250;
+    int load = (int)std::thread::hardware_concurrency() * 2;
+    const char* configPath = NULL;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--seconds") && i + 1 < argc)
+            seconds = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--hz") && i + 1 < argc)
+            hz = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--load") && i + 1 < argc)
+            load = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--config") && i + 1 < argc)
+            configPath = argv[++i];
+        else
+        {
+            fprintf(stderr,
+                    "usage: %s [--seconds s] [--hz n] [--load threads] "
+                    "[--config config.ini]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (configPath) LoadConfig(configPath);
+    g_config.trace_file[0] = 0;
+    g_config.output_frequency = 0; // the sampler emits, as in the default
+    if (hz > 0) g_config.update_frequency = hz;
+    if (load < 0) load = 0;
+    if (load > MAX_LOAD_THREADS) load = MAX_LOAD_THREADS;
+    CompileTriggerTable(&g_triggers);
+
+    // Plain busy loops at normal priority, twice the core count by
+    // default, so a normal thread has to queue for every wake-up
+    g_loadRunning = true;
+    std::vector<std::thread> spinners;
+    for (int i = 0; i < load; i++) spinners.push_back(std::thread(SpinLoad));
+
+    printf("%d Hz ticks, %d load threads on %u cores, %.1f s per mode\n",
+           SampleFrequency(), load, std::thread::hardware_concurrency(),
+           seconds);
+    printf("%-16s %8s %8s %8s %8s\n", "mode", "ticks", "p50_ms", "p99_ms",
+           "max_ms");
+    int measured = 0;
+    for (int mode = 0; mode < JITTER_MODE_COUNT; mode++)
+    {
+        ControlMetrics m;
+        if (MeasureMode((JitterMode)mode, seconds, &m) && m.ticks) measured++;
+    }
+
+    g_loadRunning = false;
+    for (size_t i = 0; i < spinners.size(); i++) spinners[i].join();
+    return measured ? 0 : 1;
+}
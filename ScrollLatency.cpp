@@ -0,0 +1,267 @@
+// Headless pipeline benchmark: how long a pointer move takes to turn into
+// wheel output, per stage, on a virtual clock. Each trial starts a gesture
+// at rest, moves the pointer at a random phase against the tick schedule
+// and runs the real SamplerTick/EmitterTick until the output reaches the
+// new rate. Also times the CPU cost of one call of each stage.
+//   scrolllatency [--trials n] [--config config.ini]
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "ScrollEngine.h"
+
+#define LATENCY_MOVE 300     // pixels the pointer jumps off the anchor
+#define LATENCY_SETTLED 0.9  // share of the sampled rate that counts as there
+#define LATENCY_RUN_TIME 0.5 // seconds simulated after the move
+
+// --- Virtual Backend ---
+double g_now = 1000.0;
+int g_pointerY = 0;
+double g_firstEmit = -1.0; // time of the first nonzero EmitScroll
+
+void LatencyGetPointer(int* x, int* y)
+{
+    *x = 0;
+    *y = g_pointerY;
+}
+
+void LatencyEmitScroll(int vS, int hS)
+{
+    if ((vS != 0 || hS != 0) && g_firstEmit < 0.0) g_firstEmit = g_now;
+}
+
+void LatencySetFeedback(ScrollCursorType t)
+{
+}
+
+double LatencyNow()
+{
+    return g_now;
+}
+
+void LatencyWait(int ms)
+{
+}
+
+const ScrollBackend g_latencyBackend = {
+    LatencyGetPointer, LatencyEmitScroll, LatencySetFeedback, LatencyNow,
+    LatencyWait,       LatencyWait,       LatencyWait};
+
+// --- Modes ---
+typedef struct
+{
+    int sampleHz, outputHz; // outputHz 0: the sampler emits
+} LatencyMode;
+
+const LatencyMode g_modes[] = {{60, 0},    {125, 0},   {250, 0},
+                               {60, 144},  {60, 240},  {125, 240}};
+
+// Seconds from the move to each milestone of one trial
+typedef struct
+{
+    double sample;  // sampler tick that read the move
+    double emit;    // first nonzero wheel output
+    double settled; // output at LATENCY_SETTLED of the sampled rate
+} TrialTimes;
+
+typedef struct
+{
+    double samplerNs, emitterNs; // CPU time summed over every call
+    unsigned long long samplerCalls, emitterCalls;
+} CallCost;
+
+double ElapsedNs(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double, std::nano>(
+               std::chrono::steady_clock::now() - begin)
+        .count();
+}
+
+// --- Trial ---
+// The phases (0..1) place the move inside a sampling and an output period
+bool RunTrial(const LatencyMode* mode, double samplePhase, double outputPhase,
+              TrialTimes* times, CallCost* cost)
+{
+    bool decoupled = mode->outputHz > 0;
+    g_config.update_frequency = mode->sampleHz;
+    g_config.output_frequency = mode->outputHz;
+    g_pointerY = 0;
+    g_firstEmit = -1.0;
+    OnTriggerButtonDown(0, 0, 0);
+    OnPrimedMove(30, 40);
+    BeginScrolling(0, 0);
+    MotionProfile m;
+    ScaleMotionProfile(&m, 96);
+    SelectMotionProfile(&m);
+
+    SamplerState sampler;
+    BeginSampler(&sampler, decoupled);
+    EmitterState emitter;
+    memset(&emitter, 0, sizeof(emitter));
+    emitter.last = -1.0;
+    PublishVelocity(0.0f, 0.0f);
+
+    double samplePeriod = 1.0 / mode->sampleHz;
+    double outputPeriod = decoupled ? 1.0 / mode->outputHz : 0.0;
+    double start = g_now;
+    double moveAt = start + 0.25; // a few idle ticks first
+    double nextSample = moveAt - samplePhase * samplePeriod;
+    double nextOutput = moveAt - outputPhase * outputPeriod;
+    while (nextSample > start) nextSample -= samplePeriod;
+    while (decoupled && nextOutput > start) nextOutput -= outputPeriod;
+    times->sample = times->emit = times->settled = -1.0;
+
+    double rate = 0.0; // the sampled rate after the move
+    while (g_now < moveAt + LATENCY_RUN_TIME && times->settled < 0.0)
+    {
+        // Ties go to the sampler, which is what the output glides towards
+        bool sample = !decoupled || nextSample <= nextOutput;
+        g_now = sample ? nextSample : nextOutput;
+        if (g_now >= moveAt) g_pointerY = LATENCY_MOVE;
+
+        std::chrono::steady_clock::time_point begin =
+            std::chrono::steady_clock::now();
+        if (sample)
+        {
+            SamplerTick(&sampler, &g_latencyBackend);
+            cost->samplerNs += ElapsedNs(begin);
+            cost->samplerCalls++;
+            nextSample += samplePeriod;
+            if (g_now >= moveAt && times->sample < 0.0)
+            {
+                VelocityMailbox published;
+                published.bits = g_targetVelocity.load();
+                rate = published.rate.v;
+                times->sample = g_now - moveAt;
+            }
+        }
+        else
+        {
+            EmitterTick(&emitter, &g_latencyBackend);
+            cost->emitterNs += ElapsedNs(begin);
+            cost->emitterCalls++;
+            nextOutput += outputPeriod;
+        }
+
+        if (g_firstEmit >= moveAt && times->emit < 0.0)
+            times->emit = g_firstEmit - moveAt;
+        // The sampler emits the whole rate at once, the emitter glides
+        bool settled = times->emit >= 0.0;
+        if (decoupled)
+            settled = settled && rate != 0.0 &&
+                      fabs(emitter.curV) >= fabs(rate) * LATENCY_SETTLED;
+        if (settled) times->settled = g_now - moveAt;
+    }
+
+    OnTriggerButtonUp(0);
+    EndScrolling();
+    g_scrollState = STATE_IDLE;
+    g_now += 1.0;
+    return times->settled >= 0.0;
+}
+
+// --- Report ---
+void Summarize(std::vector<double>* v, double* avg, double* p99)
+{
+    std::sort(v->begin(), v->end());
+    double sum = 0.0;
+    for (size_t i = 0; i < v->size(); i++) sum += (*v)[i];
+    *avg = v->empty() ? 0.0 : sum / v->size();
+    *p99 = v->empty() ? 0.0 : (*v)[(v->size() - 1) * 99 / 100];
+}
+
+// Runs every trial of one mode; false if one missed its bound
+bool MeasureMode(const LatencyMode* mode, int trials)
+{
+    std::vector<double> sample, emit, settled;
+    CallCost cost = {0.0, 0.0, 0, 0};
+    bool ok = true;
+    for (int i = 0; i < trials; i++)
+    {
+        // Low-discrepancy phases cover both periods evenly
+        double samplePhase = (i * 0.6180339887) - (int)(i * 0.6180339887);
+        double outputPhase = (i * 0.7548776662) - (int)(i * 0.7548776662);
+        TrialTimes t;
+        if (!RunTrial(mode, samplePhase, outputPhase, &t, &cost))
+        {
+            ok = false;
+            continue;
+        }
+        sample.push_back(t.sample * 1000);
+        emit.push_back(t.emit * 1000);
+        settled.push_back(t.settled * 1000);
+    }
+
+    double sampleAvg, sampleP99, emitAvg, emitP99, settledAvg, settledP99;
+    Summarize(&sample, &sampleAvg, &sampleP99);
+    Summarize(&emit, &emitAvg, &emitP99);
+    Summarize(&settled, &settledAvg, &settledP99);
+    char name[32];
+    if (mode->outputHz)
+        snprintf(name, sizeof(name), "%d->%d Hz", mode->sampleHz,
+                 mode->outputHz);
+    else
+        snprintf(name, sizeof(name), "%d Hz", mode->sampleHz);
+    double samplerNs = cost.samplerCalls ? cost.samplerNs / cost.samplerCalls
+                                         : 0.0;
+    double emitterNs = cost.emitterCalls ? cost.emitterNs / cost.emitterCalls
+                                         : 0.0;
+    printf("%-12s %6.1f %6.1f %6.1f %6.1f %7.1f %7.1f %8.0f %8.0f\n", name,
+           sampleAvg, sampleP99, emitAvg, emitP99, settledAvg, settledP99,
+           samplerNs, emitterNs);
+
+    // A move is read by the next sampling tick and, decoupled, goes out
+    // with the output tick after that
+    double bound = 1000.0 / mode->sampleHz +
+                   (mode->outputHz ? 1000.0 / mode->outputHz : 0.0) + 1e-6;
+    if (!ok || sampleP99 > 1000.0 / mode->sampleHz + 1e-6 ||
+        (int)emit.size() != trials || emit.front() < 0.0 ||
+        emit.back() > bound)
+    {
+        fprintf(stderr, "%s: output later than %.1f ms or missing\n", name,
+                bound);
+        return false;
+    }
+    return true;
+}
+
+// --- Entry Point ---
+int main(int argc, char** argv)
+{
+    int trials = 500;
+    const char* configPath = NULL;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--trials") && i + 1 < argc)
+            trials = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--config") && i + 1 < argc)
+            configPath = argv[++i];
+        else
+        {
+            fprintf(stderr, "usage: %s [--trials n] [--config config.ini]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (configPath) LoadConfig(configPath);
+    g_config.trace_file[0] = 0;
+    if (trials < 1) trials = 1;
+    CompileTriggerTable(&g_triggers);
+
+    // Milliseconds from the move: to the sampler tick that reads it, to
+    // the first wheel output, to output at the full rate
+    printf("%d trials per mode, pointer moved %d px\n", trials, LATENCY_MOVE);
+    printf("%-12s %6s %6s %6s %6s %7s %7s %8s %8s\n", "mode", "sample",
+           "p99", "emit", "p99", "settled", "p99", "sampler", "emitter");
+    printf("%-12s %6s %6s %6s %6s %7s %7s %8s %8s\n", "", "ms", "ms", "ms",
+           "ms", "ms", "ms", "ns/call", "ns/call");
+    bool ok = true;
+    for (size_t i = 0; i < sizeof(g_modes) / sizeof(g_modes[0]); i++)
+        ok = MeasureMode(&g_modes[i], trials) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,562 @@
+// Replays a trace_file recording through the scroll engine on a virtual
+// clock. With the recorded config the emitted stream must match the
+// recording exactly; pass a config.ini to see how other settings behave.
+// Every tick is also checked against the worker budget: one pointer read
+// per sample, at most one emit and one feedback call, at most
+// WHEEL_TICK_MESSAGES calls on the Win32 message path (the hang check of
+// an overdue acknowledgement included), no heap allocation. The target
+// acknowledges each message in the wait after the tick that sent it, or
+// --ack-lag ticks later. --compare-filter replays the trace
+// without input_filter and with it (one_euro if the config has none) and
+// prints how much the output jitters and how many messages each sends.
+// --check-cruise also checks the distance replayed while each cruise rate
+// was locked against rate x time, within CRUISE_TOLERANCE.
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <new>
+
+#include "ScrollEngine.h"
+
+#define CRUISE_TOLERANCE 0.001 // of the distance a locked rate should cover
+
+// --- Replay State ---
+const TraceRecord* g_current = NULL; // record being fed to the engine
+TraceRecord* g_output = NULL;
+size_t g_outputCount = 0, g_outputCapacity = 0;
+
+// --- Tick Budget ---
+bool g_inTick = false;
+int g_tickCaptures = 0, g_tickEmits = 0, g_tickFeedback = 0;
+int g_tickMessages = 0;
+size_t g_tickAllocations = 0, g_overBudget = 0;
+
+// --- Wheel Target ---
+// The Win32 message path, acknowledged the way its pumping wait collects
+// acknowledgements: before the emit call ackLag + 1 after the one that sent
+// the message. More in flight than the queue holds count as lost.
+#define MAX_REPLAY_ACKS 256
+
+typedef struct
+{
+    double sent;
+    size_t due; // g_emitCalls value that collects it
+} ReplayAck;
+
+WheelFlow g_wheelFlow;
+ReplayAck g_acks[MAX_REPLAY_ACKS];
+size_t g_ackHead = 0, g_ackTail = 0;
+size_t g_ackLag = 0, g_hangChecks = 0;
+
+// --- Output Statistics ---
+// Per emit call, zeros included: messages the Win32 backend would send and
+// the change in emitted amount from the previous tick of the gesture
+size_t g_emitCalls = 0, g_messageCount = 0;
+int g_lastV = 0, g_lastH = 0;
+double g_changeSumV = 0.0, g_changeSumH = 0.0;
+double g_changeSquaresV = 0.0, g_changeSquaresH = 0.0;
+
+// The C allocator is replaced as a whole where the C library allows it
+// (glibc), so calloc/realloc and allocations inside libc count too.
+// Elsewhere only operator new is seen.
+#ifdef __GLIBC__
+extern "C"
+{
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t count, size_t size);
+    void* __libc_realloc(void* p, size_t size);
+
+    void* malloc(size_t size) __THROW
+    {
+        if (g_inTick) g_tickAllocations++;
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size) __THROW
+    {
+        if (g_inTick) g_tickAllocations++;
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* p, size_t size) __THROW
+    {
+        if (g_inTick) g_tickAllocations++;
+        return __libc_realloc(p, size);
+    }
+}
+#define ALLOCATOR_REPLACED 1
+#else
+#define ALLOCATOR_REPLACED 0
+#endif
+
+void* operator new(size_t size)
+{
+    if (g_inTick && !ALLOCATOR_REPLACED) g_tickAllocations++;
+    void* p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void BeginTick()
+{
+    g_tickCaptures = g_tickEmits = g_tickFeedback = g_tickMessages = 0;
+    g_tickAllocations = 0;
+    g_inTick = true;
+}
+
+void EndTick(int captures)
+{
+    g_inTick = false;
+    if (g_tickCaptures != captures || g_tickEmits > 1 || g_tickFeedback > 1 ||
+        g_tickMessages > WHEEL_TICK_MESSAGES || g_tickAllocations != 0)
+        g_overBudget++;
+}
+
+// --- Replay Backend ---
+void ReplayGetPointer(int* x, int* y)
+{
+    g_tickCaptures++;
+    *x = g_current->a;
+    *y = g_current->b;
+}
+
+// What the Win32 EmitScroll would call for this emit, after the wait
+// before it collected the acknowledgements that were due
+void ReplayWheelMessages(int vS, int hS)
+{
+    double now = g_current->time;
+    WheelFlow* f = &g_wheelFlow;
+    while (g_ackHead != g_ackTail &&
+           g_acks[g_ackHead % MAX_REPLAY_ACKS].due <= g_emitCalls)
+    {
+        const ReplayAck* a = &g_acks[g_ackHead++ % MAX_REPLAY_ACKS];
+        AckWheelMessage(f, now - a->sent, now);
+    }
+
+    f->pendingV += vS;
+    f->pendingH += hS;
+    if (f->pendingV == 0 && f->pendingH == 0) return;
+    // IsHungAppWindow; this target never hangs
+    if (g_config.max_pending_messages > 0 && WheelAckOverdue(f, now))
+    {
+        g_tickMessages++;
+        g_hangChecks++;
+    }
+    WheelMessage messages[WHEEL_TICK_MESSAGES];
+    int planned = PlanWheelMessages(f, g_config.max_pending_messages, now,
+                                    messages);
+    for (int i = 0; i < planned; i++)
+    {
+        if (!messages[i].ack) continue;
+        if (g_ackTail - g_ackHead == MAX_REPLAY_ACKS)
+        {
+            AckWheelMessage(f, -1.0, now);
+            continue;
+        }
+        ReplayAck a = {now, g_emitCalls + 1 + g_ackLag};
+        g_acks[g_ackTail++ % MAX_REPLAY_ACKS] = a;
+    }
+    g_tickMessages += planned;
+    g_messageCount += planned;
+}
+
+void ReplayEmitScroll(int vS, int hS)
+{
+    g_tickEmits++;
+    ReplayWheelMessages(vS, hS);
+    g_emitCalls++;
+    g_changeSumV += vS - g_lastV;
+    g_changeSumH += hS - g_lastH;
+    g_changeSquaresV += (double)(vS - g_lastV) * (vS - g_lastV);
+    g_changeSquaresH += (double)(hS - g_lastH) * (hS - g_lastH);
+    g_lastV = vS;
+    g_lastH = hS;
+
+    if (vS == 0 && hS == 0) return;
+    if (g_outputCount == g_outputCapacity)
+    {
+        // The replay's own bookkeeping, not the engine's
+        bool inTick = g_inTick;
+        g_inTick = false;
+        g_outputCapacity = g_outputCapacity ? g_outputCapacity * 2 : 1024;
+        size_t bytes = g_outputCapacity * sizeof(TraceRecord);
+        g_output = (TraceRecord*)realloc(g_output, bytes);
+        g_inTick = inTick;
+    }
+    TraceRecord r = {TRACE_EMIT, vS, hS, 0, g_current->time};
+    g_output[g_outputCount++] = r;
+}
+
+void ReplaySetFeedback(ScrollCursorType t)
+{
+    g_tickFeedback++;
+}
+
+double ReplayNow()
+{
+    return g_current->time;
+}
+
+void ReplayWait(int ms)
+{
+}
+
+const ScrollBackend g_replayBackend = {ReplayGetPointer, ReplayEmitScroll,
+                                       ReplaySetFeedback, ReplayNow,
+                                       ReplayWait,        ReplayWait,
+                                       ReplayWait};
+
+// --- Replay ---
+typedef struct
+{
+    size_t samples, recordedEmits;
+    bool diverged;
+    size_t mismatch; // first emit that differs from the recording
+} ReplayResult;
+
+// Everything after the header, into memory so a trace can be replayed
+// more than once
+TraceRecord* ReadRecords(FILE* file, size_t* count)
+{
+    TraceRecord* records = NULL;
+    size_t capacity = 0;
+    *count = 0;
+    TraceRecord r;
+    while (fread(&r, sizeof(r), 1, file) == 1)
+    {
+        if (*count == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 4096;
+            records = (TraceRecord*)realloc(records,
+                                            capacity * sizeof(TraceRecord));
+        }
+        records[(*count)++] = r;
+    }
+    return records;
+}
+
+// Fresh engine and replay state for a pass with the current g_config
+void ResetReplay()
+{
+    g_outputCount = 0;
+    g_overBudget = 0;
+    g_emitCalls = g_messageCount = 0;
+    g_hangChecks = 0;
+    g_lastV = g_lastH = 0;
+    g_changeSumV = g_changeSumH = 0.0;
+    g_changeSquaresV = g_changeSquaresH = 0.0;
+    g_scrollState = STATE_IDLE;
+    g_cruiseVelocity.store(0);
+    CompileTriggerTable(&g_triggers);
+    ScaleMotionProfile(&g_motion, 96);
+}
+
+void ReplayTrace(const TraceRecord* records, size_t count, ReplayResult* res)
+{
+    memset(res, 0, sizeof(ReplayResult));
+    SamplerState sampler;
+    EmitterState emitter;
+    for (size_t i = 0; i < count; i++)
+    {
+        TraceRecord r = records[i];
+        g_current = &r;
+        if (r.binding < 0 || r.binding >= MAX_TRIGGER_BINDINGS) r.binding = 0;
+        switch (r.type)
+        {
+        case TRACE_BUTTON_DOWN:
+            OnTriggerButtonDown(r.binding, r.a, r.b);
+            break;
+        case TRACE_BUTTON_UP:
+            OnTriggerButtonUp(r.binding);
+            break;
+        case TRACE_PRIMED_MOVE:
+            OnPrimedMove(r.a, r.b);
+            break;
+        case TRACE_KEY_DOWN:
+            OnTriggerKeyDown(r.binding);
+            break;
+        case TRACE_KEY_UP:
+            OnTriggerKeyUp(r.binding);
+            break;
+        case TRACE_CANCEL:
+            OnCancel();
+            break;
+        case TRACE_CRUISE:
+            g_cruiseVelocity.store((unsigned int)r.a |
+                                   (unsigned long long)(unsigned int)r.b
+                                       << 32);
+            break;
+        case TRACE_MOTION:
+        {
+            MotionProfile m;
+            ScaleMotionProfile(&m, r.a);
+            SelectMotionProfile(&m);
+            break;
+        }
+        // Actions come from the recorded transitions, not from the state
+        // machine's answers, so a config override cannot desync the replay.
+        case TRACE_BEGIN:
+            g_scrollState = STATE_IDLE;
+            BeginScrolling(r.a, r.b);
+            BeginSampler(&sampler, g_config.output_frequency > 0);
+            memset(&emitter, 0, sizeof(emitter));
+            emitter.last = -1.0;
+            PublishVelocity(0.0f, 0.0f);
+            ResetWheelFlow(&g_wheelFlow);
+            g_ackHead = g_ackTail = 0;
+            g_lastV = g_lastH = 0;
+            break;
+        case TRACE_END:
+            EndScrolling();
+            g_scrollState = STATE_IDLE;
+            break;
+        case TRACE_SAMPLE:
+            res->samples++;
+            BeginTick();
+            SamplerTick(&sampler, &g_replayBackend);
+            EndTick(1);
+            break;
+        case TRACE_EMITTER_TICK:
+            BeginTick();
+            EmitterTick(&emitter, &g_replayBackend);
+            EndTick(0);
+            break;
+        case TRACE_EMIT:
+            if (!res->diverged &&
+                (res->recordedEmits >= g_outputCount ||
+                 memcmp(&r, &g_output[res->recordedEmits], sizeof(r)) != 0))
+            {
+                res->diverged = true;
+                res->mismatch = res->recordedEmits;
+            }
+            res->recordedEmits++;
+            break;
+        }
+    }
+    g_current = NULL;
+    if (!res->diverged && res->recordedEmits != g_outputCount)
+    {
+        res->diverged = true;
+        res->mismatch = res->recordedEmits < g_outputCount
+                            ? res->recordedEmits
+                            : g_outputCount;
+    }
+}
+
+static double ChangeVariance(double sum, double squares)
+{
+    if (g_emitCalls == 0) return 0.0;
+    double mean = sum / g_emitCalls;
+    return squares / g_emitCalls - mean * mean;
+}
+
+// One pass per filter setting, everything else as configured
+int CompareFilter(const TraceRecord* records, size_t count)
+{
+    static const char* names[] = {"none", "ema", "one_euro"};
+    AppConfig base = g_config;
+    InputFilter passes[2] = {FILTER_NONE, base.input_filter};
+    if (passes[1] == FILTER_NONE) passes[1] = FILTER_ONE_EURO;
+
+    printf("%-9s %8s %9s %12s %12s %10s %10s\n", "filter", "emits",
+           "messages", "change_var_v", "change_var_h", "distance_v",
+           "distance_h");
+    size_t overBudget = 0;
+    for (int pass = 0; pass < 2; pass++)
+    {
+        g_config = base;
+        g_config.input_filter = passes[pass];
+        ResetReplay();
+        ReplayResult res;
+        ReplayTrace(records, count, &res);
+        overBudget += g_overBudget;
+        long long totalV = 0, totalH = 0;
+        for (size_t i = 0; i < g_outputCount; i++)
+        {
+            totalV += g_output[i].a;
+            totalH += g_output[i].b;
+        }
+        printf("%-9s %8zu %9zu %12.2f %12.2f %10lld %10lld\n",
+               names[passes[pass]], g_outputCount, g_messageCount,
+               ChangeVariance(g_changeSumV, g_changeSquaresV),
+               ChangeVariance(g_changeSumH, g_changeSquaresH), totalV, totalH);
+    }
+    if (overBudget)
+        printf("budget: EXCEEDED in %zu ticks\n", overBudget);
+    else
+        printf("budget: ok\n");
+    return overBudget ? 3 : 0;
+}
+
+// --- Cruise Accuracy ---
+// One locked rate, from the tick that picked it up (its emit still covers
+// time from before) to the last tick before the next rate or the end
+bool CheckCruiseSegment(VelocityMailbox rate, double from, double to)
+{
+    long long v = 0, h = 0;
+    for (size_t i = 0; i < g_outputCount; i++)
+    {
+        if (g_output[i].time <= from || g_output[i].time > to) continue;
+        v += g_output[i].a;
+        h += g_output[i].b;
+    }
+    double wantV = rate.rate.v * (to - from);
+    double wantH = rate.rate.h * (to - from);
+    double want = sqrt(wantV * wantV + wantH * wantH);
+    double off = sqrt((v - wantV) * (v - wantV) + (h - wantH) * (h - wantH));
+    double error = want > 0.0 ? off / want : 0.0;
+    printf("cruise: %.1f/%.1f per s for %.1f s, delivered v=%lld h=%lld, "
+           "off by %.4f%%\n",
+           rate.rate.v, rate.rate.h, to - from, v, h, error * 100);
+    return want > 0.0 && error <= CRUISE_TOLERANCE;
+}
+
+// Run after a replay; false if a rate was off or the trace never cruised
+bool CheckCruise(const TraceRecord* records, size_t count)
+{
+    VelocityMailbox rate;
+    rate.bits = 0;
+    double from = 0.0, lastTick = 0.0;
+    int segments = 0, failed = 0;
+    for (size_t i = 0; i <= count; i++)
+    {
+        const TraceRecord* r = i < count ? &records[i] : NULL;
+        if (rate.bits && (!r || r->type == TRACE_CRUISE ||
+                          r->type == TRACE_END))
+        {
+            segments++;
+            if (!CheckCruiseSegment(rate, from, lastTick)) failed++;
+            rate.bits = 0;
+        }
+        if (!r) break;
+        if (r->type == TRACE_CRUISE)
+        {
+            rate.bits = (unsigned int)r->a |
+                        (unsigned long long)(unsigned int)r->b << 32;
+            from = r->time;
+        }
+        else if (r->type == TRACE_SAMPLE || r->type == TRACE_EMITTER_TICK)
+        {
+            lastTick = r->time;
+        }
+    }
+    if (segments == 0)
+        printf("cruise: none in this trace\n");
+    else if (failed)
+        printf("cruise: OFF TARGET in %d of %d rates\n", failed, segments);
+    else
+        printf("cruise: ok\n");
+    return segments > 0 && failed == 0;
+}
+
+// --- Entry Point ---
+int main(int argc, char** argv)
+{
+    // Positional: trace.bin [config.ini] [out.bin]
+    const char* args[3] = {NULL, NULL, NULL};
+    int argCount = 0;
+    bool compareFilter = false, checkCruise = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--compare-filter"))
+            compareFilter = true;
+        else if (!strcmp(argv[i], "--check-cruise"))
+            checkCruise = true;
+        else if (!strcmp(argv[i], "--ack-lag") && i + 1 < argc)
+            g_ackLag = strtoul(argv[++i], NULL, 10);
+        else if (argCount < 3)
+            args[argCount++] = argv[i];
+    }
+    if (argCount < 1)
+    {
+        fprintf(stderr,
+                "usage: %s [--check-cruise] [--ack-lag ticks] trace.bin "
+                "[config.ini] [out.bin]\n"
+                "       %s --compare-filter trace.bin [config.ini]\n",
+                argv[0], argv[0]);
+        return 1;
+    }
+
+    FILE* file = fopen(args[0], "rb");
+    if (!file)
+    {
+        fprintf(stderr, "cannot open %s\n", args[0]);
+        return 1;
+    }
+    TraceHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        header.magic != TRACE_MAGIC || header.version != TRACE_VERSION ||
+        header.configSize != sizeof(AppConfig) ||
+        header.recordSize != sizeof(TraceRecord) ||
+        fread(&g_config, sizeof(AppConfig), 1, file) != 1)
+    {
+        fprintf(stderr, "%s: not a trace from this build\n", args[0]);
+        return 1;
+    }
+    size_t count = 0;
+    TraceRecord* records = ReadRecords(file, &count);
+    fclose(file);
+    g_config.trace_file[0] = 0;
+    bool overridden = args[1] && strcmp(args[1], "-") != 0;
+    if (overridden) LoadConfig(args[1]);
+    if (compareFilter)
+    {
+        int status = CompareFilter(records, count);
+        free(records);
+        free(g_output);
+        return status;
+    }
+
+    ResetReplay();
+    ReplayResult res;
+    ReplayTrace(records, count, &res);
+
+    long long totalV = 0, totalH = 0;
+    for (size_t i = 0; i < g_outputCount; i++)
+    {
+        totalV += g_output[i].a;
+        totalH += g_output[i].b;
+    }
+    printf("samples: %zu\nrecorded emits: %zu\nreplayed emits: %zu\n"
+           "replayed distance: v=%lld h=%lld\n",
+           res.samples, res.recordedEmits, g_outputCount, totalV, totalH);
+    printf("messages: %zu\nhang checks: %zu\n", g_messageCount, g_hangChecks);
+    if (g_overBudget)
+        printf("budget: EXCEEDED in %zu ticks\n", g_overBudget);
+    else
+        printf("budget: ok\n");
+    if (!overridden)
+    {
+        if (res.diverged)
+            printf("result: DIVERGED at emit #%zu\n", res.mismatch);
+        else
+            printf("result: identical\n");
+    }
+    bool cruiseOk = !checkCruise || CheckCruise(records, count);
+    free(records);
+
+    if (args[2])
+    {
+        FILE* out = fopen(args[2], "wb");
+        if (!out)
+        {
+            fprintf(stderr, "cannot write %s\n", args[2]);
+            return 1;
+        }
+        fwrite(&header, sizeof(header), 1, out);
+        fwrite(&g_config, sizeof(AppConfig), 1, out);
+        fwrite(g_output, sizeof(TraceRecord), g_outputCount, out);
+        fclose(out);
+    }
+    free(g_output);
+    if (!overridden && res.diverged) return 2;
+    if (g_overBudget) return 3;
+    return cruiseOk ? 0 : 4;
+}
@@ -0,0 +1,215 @@
+// Benchmark corpus for statsmerge: writes n stats files with the app's own
+// writer, a thousand per machine folder like a collection share, plus an
+// empty file and an .ini without stats. With --merge it then times the
+// given statsmerge over the corpus at 1, 2, 4, ... threads up to the core
+// count (warm cache, process start and directory walk included) and checks
+// every run's totals against the sums of what was written.
+//   statscorpus [--files n] [--dir directory] [--merge statsmerge] [--keep]
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#define popen _popen
+#define pclose _pclose
+#define MakeDir(path) _mkdir(path)
+#define RemoveDir(path) _rmdir(path)
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#define MakeDir(path) mkdir(path, 0755)
+#define RemoveDir(path) rmdir(path)
+#endif
+
+#include <chrono>
+#include <thread>
+
+#include "ScrollEngine.h"
+
+#define FILES_PER_MACHINE 1000
+#define MAX_MERGE_OUTPUT 4096
+
+// --- Corpus ---
+// Same numbers every run, different for every file
+void MachineStats(size_t i, Stats* s)
+{
+    s->dir_up = i * 7919 % 50000;
+    s->dir_down = i * 104729 % 80000;
+    s->dir_left = i % 977;
+    s->dir_right = i * 31 % 1999;
+    s->total_pixels = s->dir_up + s->dir_down + s->dir_left + s->dir_right;
+    s->session_pixels = i % 100;
+}
+
+void FilePath(char* path, size_t size, const char* root, size_t i)
+{
+    snprintf(path, size, "%s/m%04zu/stats%07zu.ini", root,
+             i / FILES_PER_MACHINE, i);
+}
+
+void MachinePath(char* path, size_t size, const char* root, size_t machine)
+{
+    snprintf(path, size, "%s/m%04zu", root, machine);
+}
+
+// Fills the totals statsmerge has to arrive at
+bool WriteCorpus(const char* root, size_t files, Stats* total)
+{
+    memset(total, 0, sizeof(*total));
+    MakeDir(root);
+    char path[4096];
+    for (size_t i = 0; i < files; i++)
+    {
+        if (i % FILES_PER_MACHINE == 0)
+        {
+            MachinePath(path, sizeof(path), root, i / FILES_PER_MACHINE);
+            MakeDir(path);
+        }
+        Stats s;
+        MachineStats(i, &s);
+        FilePath(path, sizeof(path), root, i);
+        if (!WriteStatsFile(path, &s)) return false;
+        MergeStats(total, &s);
+    }
+    // Both have to be skipped, not counted
+    snprintf(path, sizeof(path), "%s/empty.ini", root);
+    FILE* file = fopen(path, "w");
+    if (!file) return false;
+    fclose(file);
+    snprintf(path, sizeof(path), "%s/desktop.ini", root);
+    file = fopen(path, "w");
+    if (!file) return false;
+    fputs("[.ShellClassInfo]\nIconResource=imageres.dll,-3\n", file);
+    fclose(file);
+    return true;
+}
+
+void RemoveCorpus(const char* root, size_t files)
+{
+    char path[4096];
+    for (size_t i = 0; i < files; i++)
+    {
+        FilePath(path, sizeof(path), root, i);
+        remove(path);
+        if (i % FILES_PER_MACHINE == FILES_PER_MACHINE - 1 || i == files - 1)
+        {
+            MachinePath(path, sizeof(path), root, i / FILES_PER_MACHINE);
+            RemoveDir(path);
+        }
+    }
+    snprintf(path, sizeof(path), "%s/empty.ini", root);
+    remove(path);
+    snprintf(path, sizeof(path), "%s/desktop.ini", root);
+    remove(path);
+    RemoveDir(root);
+}
+
+// --- Timing Run ---
+// Value of "key" in statsmerge's json, or ~0 if it is missing
+unsigned long long JsonValue(const char* json, const char* key)
+{
+    char quoted[64];
+    snprintf(quoted, sizeof(quoted), "\"%s\":", key);
+    const char* at = strstr(json, quoted);
+    return at ? strtoull(at + strlen(quoted), NULL, 10) : ~0ULL;
+}
+
+// One statsmerge run; false if it failed or its totals are wrong
+bool TimeMerge(const char* merge, const char* root, int threads,
+               size_t files, const Stats* want, double* ms)
+{
+    char command[8192];
+    snprintf(command, sizeof(command), "\"%s\" --threads %d \"%s\"", merge,
+             threads, root);
+    fflush(stdout); // keeps its stderr line after ours
+    std::chrono::steady_clock::time_point begin =
+        std::chrono::steady_clock::now();
+    FILE* out = popen(command, "r");
+    if (!out) return false;
+    char json[MAX_MERGE_OUTPUT];
+    size_t length = fread(json, 1, sizeof(json) - 1, out);
+    json[length] = 0;
+    int status = pclose(out);
+    *ms = std::chrono::duration<double, std::milli>(
+              std::chrono::steady_clock::now() - begin)
+              .count();
+
+    return status == 0 && JsonValue(json, "files") == files &&
+           JsonValue(json, "skipped") == 2 &&
+           JsonValue(json, "total_pixels") == want->total_pixels &&
+           JsonValue(json, "up") == want->dir_up &&
+           JsonValue(json, "down") == want->dir_down &&
+           JsonValue(json, "left") == want->dir_left &&
+           JsonValue(json, "right") == want->dir_right &&
+           JsonValue(json, "unuploaded") == want->session_pixels;
+}
+
+// --- Entry Point ---
+int main(int argc, char** argv)
+{
+    size_t files = 100000;
+    const char* dir = ".";
+    const char* merge = NULL;
+    bool keep = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--files") && i + 1 < argc)
+            files = strtoull(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "--dir") && i + 1 < argc)
+            dir = argv[++i];
+        else if (!strcmp(argv[i], "--merge") && i + 1 < argc)
+            merge = argv[++i];
+        else if (!strcmp(argv[i], "--keep"))
+            keep = true;
+        else
+        {
+            fprintf(stderr,
+                    "usage: %s [--files n] [--dir directory] "
+                    "[--merge statsmerge] [--keep]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (files < 1) files = 1;
+
+    char root[4096];
+    snprintf(root, sizeof(root), "%s/stats-corpus", dir);
+    std::chrono::steady_clock::time_point begin =
+        std::chrono::steady_clock::now();
+    Stats want;
+    if (!WriteCorpus(root, files, &want))
+    {
+        fprintf(stderr, "cannot write the corpus below %s\n", root);
+        RemoveCorpus(root, files);
+        return 2;
+    }
+    printf("%s: %zu stats files written in %.0f ms, %llu pixels\n", root,
+           files,
+           std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now() - begin)
+               .count(),
+           want.total_pixels);
+
+    bool ok = true;
+    if (merge)
+    {
+        int cores = (int)std::thread::hardware_concurrency();
+        if (cores < 1) cores = 1;
+        printf("%-8s %10s %12s\n", "threads", "ms", "files/s");
+        for (int threads = 1;; threads *= 2)
+        {
+            if (threads > cores) threads = cores;
+            double ms = 0.0;
+            bool right = TimeMerge(merge, root, threads, files, &want, &ms);
+            printf("%-8d %10.1f %12.0f%s\n", threads, ms,
+                   ms > 0.0 ? files * 1000.0 / ms : 0.0,
+                   right ? "" : "  WRONG TOTALS");
+            ok = ok && right;
+            if (threads == cores) break;
+        }
+    }
+    if (!keep) RemoveCorpus(root, files);
+    return ok ? 0 : 1;
+}
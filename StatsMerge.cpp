@@ -0,0 +1,301 @@
+// Merges stats files collected from many machines into one set of totals.
+// Files are memory-mapped and parsed with the app's own stats code on all
+// cores; every worker folds its share into a partial sum and the partials
+// are combined pairwise as workers finish (a parallel tree merge).
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define NOMINMAX // <chrono> and <thread> follow
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "ScrollEngine.h"
+
+#define MAX_WORKERS 256
+#define FILES_PER_CLAIM 64 // files a worker takes from the list at a time
+
+// --- File List ---
+char** g_files = NULL;
+size_t g_fileCount = 0, g_fileCapacity = 0;
+
+// --- Workers ---
+// Each partial is written by its own worker, then read by the worker that
+// merges it once 'ready' is set.
+typedef struct
+{
+    Stats stats;
+    size_t parsed, skipped; // files with and without stats keys
+    std::atomic<bool> ready;
+    char padding[64];       // keeps neighbours off each other's cache line
+} Partial;
+
+Partial g_partials[MAX_WORKERS];
+std::atomic<size_t> g_nextFile(0);
+int g_workerCount = 1;
+
+void AddFile(const char* path)
+{
+    if (g_fileCount == g_fileCapacity)
+    {
+        g_fileCapacity = g_fileCapacity ? g_fileCapacity * 2 : 1024;
+        g_files = (char**)realloc(g_files, g_fileCapacity * sizeof(char*));
+    }
+    g_files[g_fileCount++] = strdup(path);
+}
+
+static bool HasIniExtension(const char* name)
+{
+    size_t n = strlen(name);
+    return n > 4 && !_stricmp(name + n - 4, ".ini");
+}
+
+// --- Platform ---
+#ifdef _WIN32
+// Adds every *.ini below dir; false if dir is not a directory
+bool AddDirectory(const char* dir)
+{
+    char pattern[MAX_PATH];
+    snprintf(pattern, sizeof(pattern), "%s\\*", dir);
+    WIN32_FIND_DATA fd;
+    HANDLE find = FindFirstFile(pattern, &fd);
+    if (find == INVALID_HANDLE_VALUE) return false;
+    do
+    {
+        if (!strcmp(fd.cFileName, ".") || !strcmp(fd.cFileName, ".."))
+            continue;
+        char path[MAX_PATH];
+        snprintf(path, sizeof(path), "%s\\%s", dir, fd.cFileName);
+        if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            AddDirectory(path);
+        else if (HasIniExtension(fd.cFileName))
+            AddFile(path);
+    } while (FindNextFile(find, &fd));
+    FindClose(find);
+    return true;
+}
+
+bool IsDirectory(const char* path)
+{
+    DWORD attributes = GetFileAttributes(path);
+    return attributes != INVALID_FILE_ATTRIBUTES &&
+           (attributes & FILE_ATTRIBUTE_DIRECTORY);
+}
+
+// 1 parsed, 0 no stats in it, -1 unreadable
+int ParseStatsFile(const char* path, Stats* s)
+{
+    HANDLE file = CreateFile(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                             OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) return -1;
+    LARGE_INTEGER size;
+    // Empty files cannot be mapped and hold no stats anyway
+    int result = GetFileSizeEx(file, &size) ? 0 : -1;
+    if (result == 0 && size.QuadPart > 0)
+    {
+        result = -1;
+        HANDLE mapping =
+            CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        const char* text =
+            mapping ? (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0,
+                                                 0, 0)
+                    : NULL;
+        if (text)
+        {
+            result = ParseStatsText(text, (size_t)size.QuadPart, s) ? 1 : 0;
+            UnmapViewOfFile(text);
+        }
+        if (mapping) CloseHandle(mapping);
+    }
+    CloseHandle(file);
+    return result;
+}
+#else
+bool AddDirectory(const char* dir)
+{
+    DIR* d = opendir(dir);
+    if (!d) return false;
+    struct dirent* entry;
+    while ((entry = readdir(d)) != NULL)
+    {
+        if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, ".."))
+            continue;
+        char path[4096];
+        snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+        bool isDir = entry->d_type == DT_DIR;
+        if (entry->d_type == DT_UNKNOWN)
+        {
+            struct stat st;
+            isDir = stat(path, &st) == 0 && S_ISDIR(st.st_mode);
+        }
+        if (isDir)
+            AddDirectory(path);
+        else if (HasIniExtension(entry->d_name))
+            AddFile(path);
+    }
+    closedir(d);
+    return true;
+}
+
+bool IsDirectory(const char* path)
+{
+    struct stat st;
+    return stat(path, &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+int ParseStatsFile(const char* path, Stats* s)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat st;
+    // Empty files cannot be mapped and hold no stats anyway
+    int result = fstat(fd, &st) == 0 ? 0 : -1;
+    if (result == 0 && st.st_size > 0)
+    {
+        result = -1;
+        void* text = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (text != MAP_FAILED)
+        {
+            result =
+                ParseStatsText((const char*)text, st.st_size, s) ? 1 : 0;
+            munmap(text, st.st_size);
+        }
+    }
+    close(fd);
+    return result;
+}
+#endif
+
+// --- Merge ---
+void MergeWorker(int id)
+{
+    Partial* mine = &g_partials[id];
+    for (;;)
+    {
+        size_t first = g_nextFile.fetch_add(FILES_PER_CLAIM);
+        if (first >= g_fileCount) break;
+        size_t last = first + FILES_PER_CLAIM;
+        if (last > g_fileCount) last = g_fileCount;
+        for (size_t i = first; i < last; i++)
+        {
+            Stats s;
+            int result = ParseStatsFile(g_files[i], &s);
+            if (result > 0)
+            {
+                MergeStats(&mine->stats, &s);
+                mine->parsed++;
+            }
+            else
+            {
+                if (result < 0)
+                    fprintf(stderr, "cannot read %s\n", g_files[i]);
+                mine->skipped++;
+            }
+        }
+    }
+
+    // Worker id absorbs id + 1, id + 2, id + 4, ... until its index has the
+    // stride bit set; that worker's partial already holds its own subtree.
+    for (int stride = 1; stride < g_workerCount; stride *= 2)
+    {
+        if (id & stride) break;
+        int peer = id + stride;
+        if (peer >= g_workerCount) continue;
+        Partial* theirs = &g_partials[peer];
+        while (!theirs->ready.load()) std::this_thread::yield();
+        MergeStats(&mine->stats, &theirs->stats);
+        mine->parsed += theirs->parsed;
+        mine->skipped += theirs->skipped;
+    }
+    mine->ready.store(true);
+}
+
+// --- Output ---
+void PrintJson(const Partial* p)
+{
+    const Stats* s = &p->stats;
+    printf("{\n  \"files\": %zu,\n  \"skipped\": %zu,\n"
+           "  \"total_pixels\": %llu,\n  \"kilometres\": %.3f,\n"
+           "  \"up\": %llu,\n  \"down\": %llu,\n  \"left\": %llu,\n"
+           "  \"right\": %llu,\n  \"unuploaded\": %llu\n}\n",
+           p->parsed, p->skipped, s->total_pixels,
+           (double)s->total_pixels * 0.0254 / 96.0 / 1000.0, s->dir_up,
+           s->dir_down, s->dir_left, s->dir_right, s->session_pixels);
+}
+
+void PrintCsv(const Partial* p)
+{
+    const Stats* s = &p->stats;
+    printf("files,skipped,total_pixels,kilometres,up,down,left,right,"
+           "unuploaded\n%zu,%zu,%llu,%.3f,%llu,%llu,%llu,%llu,%llu\n",
+           p->parsed, p->skipped, s->total_pixels,
+           (double)s->total_pixels * 0.0254 / 96.0 / 1000.0, s->dir_up,
+           s->dir_down, s->dir_left, s->dir_right, s->session_pixels);
+}
+
+// --- Entry Point ---
+int main(int argc, char** argv)
+{
+    bool csv = false;
+    int threads = (int)std::thread::hardware_concurrency();
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--csv"))
+            csv = true;
+        else if (!strcmp(argv[i], "--json"))
+            csv = false;
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else if (IsDirectory(argv[i]))
+            AddDirectory(argv[i]);
+        else
+            AddFile(argv[i]);
+    }
+    if (g_fileCount == 0)
+    {
+        fprintf(stderr,
+                "usage: %s [--json|--csv] [--threads n] <stats.ini|dir>...\n"
+                "directories are searched for *.ini files\n",
+                argv[0]);
+        return 1;
+    }
+    if (threads < 1) threads = 1;
+    if (threads > MAX_WORKERS) threads = MAX_WORKERS;
+    if ((size_t)threads > g_fileCount / FILES_PER_CLAIM + 1)
+        threads = (int)(g_fileCount / FILES_PER_CLAIM + 1);
+    g_workerCount = threads;
+
+    std::chrono::steady_clock::time_point begin =
+        std::chrono::steady_clock::now();
+    std::thread* workers = new std::thread[threads];
+    for (int i = 1; i < threads; i++) workers[i] = std::thread(MergeWorker, i);
+    MergeWorker(0);
+    for (int i = 1; i < threads; i++) workers[i].join();
+    delete[] workers;
+    double elapsed = std::chrono::duration<double, std::milli>(
+                         std::chrono::steady_clock::now() - begin)
+                         .count();
+
+    if (csv)
+        PrintCsv(&g_partials[0]);
+    else
+        PrintJson(&g_partials[0]);
+    fprintf(stderr, "%zu files in %.1f ms on %d threads\n", g_fileCount,
+            elapsed, threads);
+
+    for (size_t i = 0; i < g_fileCount; i++) free(g_files[i]);
+    free(g_files);
+    return g_partials[0].parsed ? 0 : 2;
+}
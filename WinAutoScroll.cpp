@@ -1,5 +1,3 @@
-#define _USE_MATH_DEFINES
-#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -9,12 +7,23 @@
 #include <shellapi.h>
 #include <objidl.h>
 #include <gdiplus.h>
+#include <dwmapi.h>
+#include <psapi.h>
+#include <avrt.h>
+#include <sddl.h>
+#include <aclapi.h>
+
+#include "ScrollEngine.h"
 
 #pragma comment(lib, "Gdiplus.lib")
+#pragma comment(lib, "Dwmapi.lib")
+#pragma comment(lib, "Psapi.lib")
+#pragma comment(lib, "Avrt.lib")
 #pragma comment(lib, "User32.lib")
 #pragma comment(lib, "Gdi32.lib")
 #pragma comment(lib, "Shell32.lib")
 #pragma comment(lib, "Kernel32.lib")
+#pragma comment(lib, "Advapi32.lib")
 
 using namespace Gdiplus;
 
@@ -24,12 +33,26 @@ const char* REPO_SCRIPT_URL = "https://raw.githubusercontent.com/santarl/"
 
 // --- Constants & Messages ---
 #define WM_TRAYICON (WM_APP + 1)
-#define WM_APP_MBUTTON_DOWN (WM_APP + 10)
-#define WM_APP_MBUTTON_UP (WM_APP + 11)
-#define WM_APP_MOUSE_MOVE (WM_APP + 12)
+#define WM_APP_BUTTON_DOWN (WM_APP + 10)
+#define WM_APP_BUTTON_UP (WM_APP + 11)
+#define WM_APP_DRAG_START (WM_APP + 12)
 #define WM_APP_KEY_DOWN (WM_APP + 13)
 #define WM_APP_KEY_UP (WM_APP + 14)
 #define WM_APP_CANCEL (WM_APP + 15)
+#define WM_APP_CRUISE (WM_APP + 16) // wParam: 0 toggle, +1/-1 nudge
+#define WM_APP_CONTROL (WM_APP + 17) // wParam: ControlCommand
+#define WM_APP_CALIBRATED (WM_APP + 18) // lParam: TargetMeasurement*
+
+// dwExtraInfo tag on our own synthetic input ("WAS!")
+#define WAS_INPUT_SIGNATURE 0x57415321
+
+// Directions in which the target's content is at its end. Positive
+// WM_MOUSEWHEEL deltas scroll towards the top, positive WM_MOUSEHWHEEL
+// deltas towards the right.
+#define LIMIT_TOP 0x01
+#define LIMIT_BOTTOM 0x02
+#define LIMIT_LEFT 0x04
+#define LIMIT_RIGHT 0x08
 
 #define ID_MENU_EDIT_CONFIG 1000
 #define ID_MENU_RELOAD 1001
@@ -37,159 +60,252 @@ const char* REPO_SCRIPT_URL = "https://raw.githubusercontent.com/santarl/"
 #define ID_MENU_PAUSE 1003
 #define ID_MENU_STATS 1004
 #define ID_MENU_UPLOAD 1005
+#define ID_MENU_DUMP_TRACE 1006
+#define ID_MENU_RESOURCES 1007
+
+#define ID_TIMER_IDLE_TRIM 1
+#define ID_TIMER_SAVE_STATS 2
+
+// Stats are written this long after the last gesture instead of after each
+#define SAVE_STATS_DELAY_MS 5000
+
+// Point as seen by the mouse hook, packed so it can be handed over in one
+// atomic op
+typedef union
+{
+    unsigned long long bits;
+    POINT pt;
+} HookPoint;
 
-// --- Enums ---
-typedef enum
-{
-    STATE_IDLE,
-    STATE_PRIMED,
-    STATE_SCROLLING,
-    STATE_STOPPING
-} ScrollState;
-typedef enum
-{
-    SHAPE_CIRCLE,
-    SHAPE_SQUARE,
-    SHAPE_CROSS
-} Shape;
-typedef enum
-{
-    MODE_TOGGLE,
-    MODE_HOLD
-} TriggerMode;
-typedef enum
-{
-    CURSOR_NONE,
-    CURSOR_ALL,
-    CURSOR_NS,
-    CURSOR_WE,
-    CURSOR_NWSE,
-    CURSOR_NESW
-} ScrollCursorType;
-
-// --- Config & Stats ---
+// Visual state wanted by the main thread (gesture start/stop, config
+// reload) and the sampler (cursor shape), packed so writers can merge into
+// it with one CAS. The feedback thread only ever applies the newest value.
+typedef union
+{
+    unsigned long long bits;
+    struct
+    {
+        short x, y; // overlay centre
+        unsigned char visible;
+        unsigned char cursor;  // ScrollCursorType
+        unsigned char cursors; // advanced by ReloadCursors
+    } state;
+} FeedbackMailbox;
+
+// Bounds and pre-scaled motion profile of one display
 typedef struct
 {
-    int min_scroll, max_scroll;
-    float sensitivity, ramp_exponent;
-    int update_frequency;
-    int trigger_vk_code, trigger_middle_mouse, emulate_touchpad_scrolling;
-    TriggerMode trigger_mode;
-    int middle_mouse_passthrough, keyboard_passthrough, drag_threshold;
-    Shape dead_zone_shape;
-    int dead_zone;
-    int axis_lock_threshold;
-    int use_send_input_api;
-    int show_indicator;
-    Shape indicator_shape;
-    int indicator_size, indicator_cross_thickness;
-    int indicator_color_r, indicator_color_g, indicator_color_b,
-        indicator_color_a;
-    float indicator_thickness;
-    int indicator_filled;
-    int fun_stats;
-    int natural_scrolling;
-    int show_outline;
-    float outline_thickness;
-    int outline_color_r, outline_color_g, outline_color_b, outline_color_a;
-} AppConfig;
+    RECT rect;
+    MotionProfile motion;
+} MonitorScale;
 
+// Synthetic input collected for one tick or state transition and sent with
+// a single SendInput call.
 typedef struct
 {
-    unsigned long long total_pixels;
-    unsigned long long dir_up, dir_down, dir_left, dir_right;
-    unsigned long long session_pixels;
-} Stats;
-
-// clang-format off
-// lets disable bin packing here
-AppConfig g_config = {
-    1,
-    1000,
-    0.01f,
-    4.0f,
-    60,
-    0,
-    1,
-    0,
-    MODE_HOLD,
-    1,
-    1,
-    0,
-    SHAPE_CIRCLE,
-    1,
-    5,
-    0,
-    1,
-    SHAPE_CIRCLE,
-    26,
-    10,
-    255,
-    255,
-    255,
-    180,
-    6.0f,
-    0,
-    1,
-    0,
-    1,
-    1.0f,
-    100,
-    100,
-    100,
-    255
-};
-// clang-format on
-Stats g_stats = {0};
-HWND g_hTargetWnd = NULL;
+    INPUT inputs[4];
+    UINT count;
+} InputBatch;
 
 // --- Global State ---
+HWND g_hTargetWnd = NULL;
 HHOOK g_hMouseHook, g_hKeyboardHook;
-volatile ScrollState g_scrollState = STATE_IDLE;
 volatile BOOL g_isPaused = FALSE;
-POINT g_startScrollPos, g_primeStartPos;
-ULONG_PTR g_gdiplusToken;
-HWND g_hMainWnd, g_hOverlayWnd;
+ULONG_PTR g_gdiplusToken = 0; // GDI+ is started on first use
+HWND g_hMainWnd, g_hOverlayWnd = NULL;
 HINSTANCE g_hInstance;
 ScrollCursorType g_currentCursorType = CURSOR_NONE;
+WheelFlow g_wheelFlow = {0};
+volatile LONG g_gestureSendInputCalls = 0; // SendInput syscalls, last gesture
+volatile LONG g_scrollLimits = 0; // LIMIT_* bits, owned by LimitProbeThread
+HANDLE g_hLimitProbeStop = NULL;
+volatile LONG g_realtime = 0; // ControlMetrics.realtime
+// Throughput calibration. The cache and the target key belong to the main
+// thread; gain and measuring are fixed before the scroll threads start.
+CalibrationCache g_calibrations;
+BOOL g_calibrationsDirty = FALSE;
+char g_targetKey[96] = "";
+float g_targetGain = 1.0f;
+double g_gainAccV = 0.0, g_gainAccH = 0.0; // remainder of the gain
+BOOL g_measureTarget = FALSE;
+volatile LONG g_gestureWheelV = 0; // vertical units posted this gesture
+volatile LONG g_gestureSerial = 0;  // bumped by every gesture start
+
+// One gesture's burst, measured on its own thread once the gesture is over
+// and handed to the main thread with the target it was sent to
+typedef struct
+{
+    HWND vBar;
+    ScrollSnapshot before;
+    int sent;
+    LONG gesture; // g_gestureSerial of the gesture that sent the burst
+    char key[96];
+    float pixelsPerUnit;
+} TargetMeasurement;
+// Drag-threshold check done in the mouse hook while primed: only the first
+// move past drag_threshold reaches the main queue.
+DragGate g_hookDrag;
+// Grab-pan: the hook hands every move straight to the sampler. The hook
+// runs before the cursor moves, so GetCursorPos would still be one behind.
+std::atomic<unsigned long long> g_hookPointer(0);
+HANDLE g_hPointerMoved = NULL; // auto-reset, created by the first gesture
+// Swallowed trigger presses awaiting their release
+HeldButtons g_hookHeld = {0, 0, 0};
 char g_statsPath[MAX_PATH];
+double g_startupMs = 0.0;
+SIZE_T g_idleWorkingSet = 0; // right after the last idle trim
 
 // --- Cached Cursors ---
 HCURSOR g_hCursorAll = NULL, g_hCursorNS = NULL, g_hCursorWE = NULL,
         g_hCursorNWSE = NULL, g_hCursorNESW = NULL;
+// Owned by the feedback thread, which loads them for the first gesture
+BOOL g_cursorsLoaded = FALSE;
+bool g_cursorOwned[ASSET_CURSOR_COUNT]; // not a shared stock cursor
+// Scroll cursors in ASSET_CURSOR_COUNT order, with their stock fallbacks
+const char* g_cursorFiles[ASSET_CURSOR_COUNT] = {
+    "%SystemRoot%\\Cursors\\lns.cur", "%SystemRoot%\\Cursors\\lwe.cur",
+    "%SystemRoot%\\Cursors\\lnwse.cur", "%SystemRoot%\\Cursors\\lnesw.cur"};
+LPCSTR g_cursorStock[ASSET_CURSOR_COUNT] = {IDC_SIZENS, IDC_SIZEWE,
+                                             IDC_SIZENWSE, IDC_SIZENESW};
+
+// --- Shared Asset Pack ---
+// Mapped read-only for the life of the process. A reload that switches to
+// another pack leaves the old view mapped: the feedback thread may still be
+// drawing from it.
+const AssetHeader* volatile g_assets = NULL;
+
+// --- Feedback Thread ---
+// Overlay and cursor updates run there so the main thread and the workers
+// never wait on the compositor.
+std::atomic<unsigned long long> g_feedback(0);
+std::atomic<long long> g_feedbackPostedAt(0); // QPC of oldest unapplied post
+HANDLE g_hFeedbackWake = NULL;                // created with the thread
+// Post-to-screen latency, written by the feedback thread only
+LONG g_feedbackUpdates = 0;
+double g_feedbackLatencyTotalMs = 0.0, g_feedbackLatencyMaxMs = 0.0;
+
+// --- Monitor Scale Table ---
+// Rebuilt at startup, on display/DPI changes and on config reload; hooks
+// and gesture start only do a table lookup.
+#define MAX_MONITORS 16
+MonitorScale g_monitors[MAX_MONITORS];
+int g_monitorCount = 0;
+MotionProfile g_fallbackMotion; // system DPI, for points off every monitor
+
+// --- Cached Tray Icons ---
+HICON g_hIconActive = NULL, g_hIconPaused = NULL;
 
 // --- Prototypes ---
 LRESULT CALLBACK WndProc(HWND, UINT, WPARAM, LPARAM);
 LRESULT CALLBACK LowLevelMouseProc(int, WPARAM, LPARAM);
 LRESULT CALLBACK LowLevelKeyboardProc(int, WPARAM, LPARAM);
 DWORD WINAPI ScrollingThread(LPVOID);
+DWORD WINAPI EmitterThread(LPVOID);
+DWORD WINAPI LimitProbeThread(LPVOID);
+HANDLE EnterRealtime();
+DWORD WINAPI FeedbackThread(LPVOID);
+DWORD WINAPI ControlThread(LPVOID);
+PSECURITY_DESCRIPTOR ControlPipeSecurity();
+void HandleControlRequest(const ControlRequest* req, ControlReply* reply);
+ControlStatus RunControlCommand(ControlCommand c);
+void FillControlMetrics(ControlMetrics* m);
+void SetPaused(BOOL paused);
+bool ReloadConfig();
+void PathNextToExe(char* path, const char* name);
+void EnsureFeedbackThread();
+void PostFeedback(FeedbackMailbox m);
+void WakeFeedback();
+void ApplyFeedback(FeedbackMailbox* shown, FeedbackMailbox want);
+void RecordFeedbackLatency(long long postedAt);
+HWND FindScrollBarOwner(HWND hWnd, int bar);
+LONG ProbeScrollBar(HWND hWnd, int bar, LONG low, LONG high);
+void TargetKey(HWND hWnd, char* key, size_t size);
+bool TakeScrollSnapshot(HWND hWnd, ScrollSnapshot* s);
+void MeasureTarget(HWND vBar, const ScrollSnapshot* before);
+DWORD WINAPI MeasureThread(LPVOID);
+void EmitScroll(int vS, int hS);
+void PumpWheelProbes();
+int GainDelta(int delta, double* carry);
+void WaitPumping(HANDLE event, int ms);
+VOID CALLBACK WheelProbeAck(HWND, UINT, ULONG_PTR, LRESULT);
 void StartScrolling();
 void StopScrolling();
-void LoadConfig(const char*);
+void ApplyTriggerAction(TriggerAction a);
+int TriggerButtonFromMessage(WPARAM wParam, const MSLLHOOKSTRUCT* p,
+                             bool* down);
+int HeldModifiers();
 void LoadStats();
 void SaveStats();
+void LoadCalibrations();
+void SaveCalibrations();
 void CopyToClipboard(const char* text);
 void ShowLocalStats();
 void ShowUploadDialog();
+void ShowResourceUsage();
+void ScheduleIdleTrim();
+void EnablePerMonitorDpi();
+void RefreshMonitorScales();
+const MotionProfile* MotionAt(POINT pt);
 void AddTrayIcon();
 void RemoveTrayIcon();
 void ShowContextMenu();
 void UpdateTrayIconState();
 void SetScrollCursor(ScrollCursorType);
+void Win32SetFeedback(ScrollCursorType);
+// Runs on the sampler. A shape for a gesture that has already been hidden
+// is dropped.
+void Win32SetFeedback(ScrollCursorType t)
+{
+    FeedbackMailbox m, want;
+    m.bits = g_feedback.load();
+    do
+    {
+        if (!m.state.visible) return;
+        want = m;
+        want.state.cursor = (unsigned char)t;
+    } while (!g_feedback.compare_exchange_weak(m.bits, want.bits));
+    WakeFeedback();
+}
+
 void RestoreSystemCursors();
+void EnsureGdiplus();
 void CreateOverlayWindow();
 void RenderAndShowOverlay(POINT center);
 void HideOverlay();
-int CalculateScrollAmount(int delta, BOOL isTouchpad);
-void SendMouseInput(DWORD flags, DWORD mouseData);
+void BatchMouseInput(InputBatch* b, DWORD flags, DWORD mouseData);
+void FlushInputBatch(InputBatch* b);
 void LoadCursors();
-char* Trim(char*);
+void FreeCursors();
+void ReloadCursors();
+void OpenAssetPack();
+const AssetHeader* MapAssetPack(const char* path, unsigned long long source);
+bool TrustedAssetOwner(HANDLE file);
+bool PublishesSharedAssets();
+bool BuildAssetPack(const char* path, unsigned long long source);
+void DrawIndicator(Graphics* g, float scale);
+HBITMAP SharedIndicatorBitmap(int dpi, int size);
+HCURSOR SharedCursor(int index);
+void Win32GetPointer(int* x, int* y);
+double Win32Now();
+void Win32Wait(int ms);
+void Win32WaitOutput(int ms);
+void Win32WaitInput(int ms);
+
+const ScrollBackend g_win32Backend = {Win32GetPointer, EmitScroll,
+                                      Win32SetFeedback, Win32Now,
+                                      Win32Wait,        Win32WaitOutput,
+                                      Win32WaitInput};
 
 // --- Entry Point ---
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
                    LPSTR lpCmdLine, int nCmdShow)
 {
-    SetProcessDPIAware();
+    double launched = Win32Now();
+    // One set of hooks per logon session; a second launch just exits.
+    // Scripts talk to the running instance through the control pipe.
+    CreateMutex(NULL, TRUE, "Local\\WinAutoScroll");
+    if (GetLastError() == ERROR_ALREADY_EXISTS) return 0;
+    EnablePerMonitorDpi();
     g_hInstance = hInstance;
 
     GetModuleFileName(NULL, g_statsPath, MAX_PATH);
@@ -203,22 +319,31 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
     wc.hInstance = hInstance;
     wc.lpszClassName = "ScrollAppHidden";
     RegisterClassEx(&wc);
-    g_hMainWnd = CreateWindowEx(0, "ScrollAppHidden", "WinAutoScroll", 0, 0, 0,
-                                0, 0, HWND_MESSAGE, NULL, hInstance, NULL);
-
-    GdiplusStartupInput gdiplusStartupInput;
-    GdiplusStartup(&g_gdiplusToken, &gdiplusStartupInput, NULL);
-
+    // A hidden top-level window rather than a message-only one: only
+    // top-level windows see WM_DISPLAYCHANGE and WM_DPICHANGED.
+    g_hMainWnd = CreateWindowEx(WS_EX_TOOLWINDOW, "ScrollAppHidden",
+                                "WinAutoScroll", WS_POPUP, 0, 0, 0, 0, NULL,
+                                NULL, hInstance, NULL);
+
+    // GDI+, the overlay window and the cursors are set up on first use;
+    // most logon sessions never need the paused icon.
+    FlightNameThread("main");
     LoadConfig("config.ini");
+    OpenTrace(g_config.trace_file, Win32Now);
+    RefreshMonitorScales();
+    OpenAssetPack();
     LoadStats();
-    LoadCursors();
-    CreateOverlayWindow();
+    LoadCalibrations();
     AddTrayIcon();
 
     g_hMouseHook =
         SetWindowsHookEx(WH_MOUSE_LL, LowLevelMouseProc, hInstance, 0);
     g_hKeyboardHook =
         SetWindowsHookEx(WH_KEYBOARD_LL, LowLevelKeyboardProc, hInstance, 0);
+    HANDLE hControl = CreateThread(NULL, 0, ControlThread, NULL, 0, NULL);
+    if (hControl) CloseHandle(hControl);
+    g_startupMs = (Win32Now() - launched) * 1000.0;
+    ScheduleIdleTrim();
 
     MSG msg;
     while (GetMessage(&msg, NULL, 0, 0) > 0)
@@ -230,13 +355,17 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
     UnhookWindowsHookEx(g_hMouseHook);
     UnhookWindowsHookEx(g_hKeyboardHook);
     RemoveTrayIcon();
-    GdiplusShutdown(g_gdiplusToken);
+    CloseTrace();
+    if (g_hIconActive) DestroyIcon(g_hIconActive);
+    if (g_hIconPaused) DestroyIcon(g_hIconPaused);
+    if (g_gdiplusToken) GdiplusShutdown(g_gdiplusToken);
     return (int)msg.wParam;
 }
 
 // --- Logic ---
 LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
 {
+    unsigned long long begin = FlightNow();
     switch (msg)
     {
     case WM_TRAYICON:
@@ -247,9 +376,7 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
         else if (lParam == WM_MBUTTONUP)
         {
             // Middle-Click on Tray to Toggle Pause
-            g_isPaused = !g_isPaused;
-            if (g_isPaused) StopScrolling();
-            UpdateTrayIconState();
+            SetPaused(!g_isPaused);
         }
         break;
     case WM_COMMAND:
@@ -276,7 +403,7 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
             }
             break;
         case ID_MENU_RELOAD:
-            if (GetFileAttributes("config.ini") == INVALID_FILE_ATTRIBUTES)
+            if (!ReloadConfig())
             {
                 if (MessageBox(hWnd,
                                "config.ini not found!\n\nCannot reload "
@@ -292,9 +419,6 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
             }
             else
             {
-                LoadConfig("config.ini");
-                LoadStats();
-                LoadCursors();
                 MessageBox(hWnd, "Configuration Reloaded", "WinAutoScroll",
                            MB_OK);
             }
@@ -305,191 +429,385 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
         case ID_MENU_UPLOAD:
             ShowUploadDialog();
             break;
+        case ID_MENU_RESOURCES:
+            ShowResourceUsage();
+            break;
+        case ID_MENU_DUMP_TRACE:
+        {
+            char path[MAX_PATH];
+            PathNextToExe(path, "flight-trace.json");
+            if (DumpFlightTrace(path))
+                MessageBox(hWnd, path, "Flight Trace Saved", MB_OK);
+            else
+                MessageBox(hWnd, "Could not write the flight trace.",
+                           "WinAutoScroll", MB_OK | MB_ICONWARNING);
+            break;
+        }
         case ID_MENU_EXIT:
             DestroyWindow(hWnd);
             break;
         case ID_MENU_PAUSE:
-            g_isPaused = !g_isPaused;
-            if (g_isPaused) StopScrolling();
-            UpdateTrayIconState();
+            SetPaused(!g_isPaused);
             break;
         }
         break;
-    case WM_APP_MBUTTON_DOWN:
-        if (g_scrollState == STATE_IDLE)
-        {
-            g_scrollState = STATE_PRIMED;
-            GetCursorPos(&g_primeStartPos);
-        }
-        else if (g_scrollState == STATE_SCROLLING &&
-                 g_config.trigger_mode == MODE_TOGGLE)
-        {
-            StopScrolling();
-        }
+    case WM_APP_BUTTON_DOWN:
+    {
+        POINT pt = {(short)LOWORD(lParam), (short)HIWORD(lParam)};
+        // The drag threshold applies from the press on
+        if (g_scrollState == STATE_IDLE) SelectMotionProfile(MotionAt(pt));
+        ApplyTriggerAction(OnTriggerButtonDown((int)wParam, pt.x, pt.y));
         break;
-    case WM_APP_MBUTTON_UP:
-        if (g_scrollState == STATE_PRIMED)
-        {
-            g_scrollState = STATE_IDLE;
-            if (g_config.middle_mouse_passthrough)
-            {
-                SendMouseInput(MOUSEEVENTF_MIDDLEDOWN, 0);
-                SendMouseInput(MOUSEEVENTF_MIDDLEUP, 0);
-            }
-        }
-        else if (g_scrollState == STATE_SCROLLING &&
-                 g_config.trigger_mode == MODE_HOLD)
-        {
-            StopScrolling();
-        }
+    }
+    case WM_APP_BUTTON_UP:
+        ApplyTriggerAction(OnTriggerButtonUp((int)wParam));
         break;
-    case WM_APP_MOUSE_MOVE:
-        if (g_scrollState == STATE_PRIMED)
-        {
-            POINT c;
-            GetCursorPos(&c);
-            if (abs(c.x - g_primeStartPos.x) > g_config.drag_threshold ||
-                abs(c.y - g_primeStartPos.y) > g_config.drag_threshold)
-            {
-                StartScrolling();
-            }
-        }
+    case WM_APP_DRAG_START:
+        ApplyTriggerAction(
+            OnPrimedMove((short)LOWORD(lParam), (short)HIWORD(lParam)));
         break;
     case WM_APP_KEY_DOWN:
-        if (g_config.trigger_mode == MODE_HOLD)
-        {
-            StartScrolling();
-        }
-        else
-        {
-            if (g_scrollState == STATE_IDLE)
-                StartScrolling();
-            else if (g_scrollState == STATE_SCROLLING)
-                StopScrolling();
-        }
+        ApplyTriggerAction(OnTriggerKeyDown((int)wParam));
         break;
     case WM_APP_KEY_UP:
-        if (g_config.trigger_mode == MODE_HOLD) StopScrolling();
+        ApplyTriggerAction(OnTriggerKeyUp((int)wParam));
         break;
     case WM_APP_CANCEL:
-        if (g_scrollState == STATE_PRIMED)
-            g_scrollState = STATE_IDLE;
+        ApplyTriggerAction(OnCancel());
+        break;
+    case WM_APP_CRUISE:
+        if ((int)wParam == 0)
+            OnCruiseToggle();
         else
-            StopScrolling();
+            OnCruiseNudge((int)wParam);
+        break;
+    case WM_DISPLAYCHANGE:
+    case WM_DPICHANGED:
+        // Takes effect from the next gesture
+        RefreshMonitorScales();
+        break;
+    case WM_TIMER:
+        if (wParam == ID_TIMER_SAVE_STATS)
+        {
+            KillTimer(hWnd, ID_TIMER_SAVE_STATS);
+            if (g_config.fun_stats) SaveStats();
+            SaveCalibrations();
+        }
+        else if (wParam == ID_TIMER_IDLE_TRIM)
+        {
+            KillTimer(hWnd, ID_TIMER_IDLE_TRIM);
+            if (g_scrollState != STATE_IDLE)
+            {
+                ScheduleIdleTrim();
+                break;
+            }
+            // Pages come back on demand; the hooks and tray stay usable.
+            SetProcessWorkingSetSize(GetCurrentProcess(), (SIZE_T)-1,
+                                     (SIZE_T)-1);
+            PROCESS_MEMORY_COUNTERS pmc = {0};
+            pmc.cb = sizeof(pmc);
+            if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+                g_idleWorkingSet = pmc.WorkingSetSize;
+        }
         break;
+    case WM_APP_CONTROL:
+        // Sent by the control thread, which waits for the answer
+        return RunControlCommand((ControlCommand)wParam);
+    case WM_APP_CALIBRATED:
+    {
+        // Keyed by the measured gesture's target: g_targetKey may already
+        // belong to a later one
+        TargetMeasurement* m = (TargetMeasurement*)lParam;
+        RecordCalibration(&g_calibrations, m->key, m->pixelsPerUnit);
+        free(m);
+        g_calibrationsDirty = TRUE;
+        SetTimer(g_hMainWnd, ID_TIMER_SAVE_STATS, SAVE_STATS_DELAY_MS, NULL);
+        break;
+    }
     case WM_DESTROY:
         SaveStats();
+        SaveCalibrations();
         PostQuitMessage(0);
         break;
     default:
         return DefWindowProc(hWnd, msg, wParam, lParam);
     }
+    if (msg >= WM_APP_BUTTON_DOWN && msg <= WM_APP_CANCEL)
+        FlightSpan(FLIGHT_TRANSITION, msg - WM_APP, begin);
     return 0;
 }
 
-void ParseHexColor(const char* hex, int* r, int* g, int* b, int* a)
+void StartScrolling()
 {
-    if (!hex) return;
-    if (*hex == '#') hex++; // Skip '#' if present
-
-    unsigned long val = strtoul(hex, NULL, 16);
-    size_t len = strlen(hex);
-
-    if (len == 6)
-    { // Format: RRGGBB (Assume alpha = 255)
-        *r = (val >> 16) & 0xFF;
-        *g = (val >> 8) & 0xFF;
-        *b = val & 0xFF;
-        *a = 255;
-    }
-    else if (len == 8)
-    { // Format: RRGGBBAA
-        *r = (val >> 24) & 0xFF;
-        *g = (val >> 16) & 0xFF;
-        *b = (val >> 8) & 0xFF;
-        *a = val & 0xFF;
+    POINT c;
+    GetCursorPos(&c);
+    if (!BeginScrolling(c.x, c.y)) return;
+
+    POINT anchor = {g_startScrollPos.x, g_startScrollPos.y};
+    SelectMotionProfile(MotionAt(anchor));
+    g_hTargetWnd = WindowFromPoint(anchor);
+    InterlockedExchange(&g_gestureSendInputCalls, 0);
+    InterlockedIncrement(&g_gestureSerial);
+    // Known targets are scaled to the reference throughput; the first few
+    // gestures in a new one measure it.
+    g_targetGain = 1.0f;
+    g_gainAccV = g_gainAccH = 0.0;
+    g_measureTarget = FALSE;
+    if (g_config.calibrate_targets)
+    {
+        TargetKey(g_hTargetWnd, g_targetKey, sizeof(g_targetKey));
+        const Calibration* cal = FindCalibration(&g_calibrations, g_targetKey);
+        // SendInput follows the pointer, not this target
+        if (!g_config.use_send_input_api)
+            g_targetGain = CalibratedGain(cal);
+        g_measureTarget = !g_config.use_send_input_api &&
+                          (!cal || cal->samples < CALIBRATION_SAMPLES);
     }
+    if (!g_hPointerMoved)
+        g_hPointerMoved = CreateEvent(NULL, FALSE, FALSE, NULL);
+    HookPoint current;
+    current.pt = c;
+    g_hookPointer.store(current.bits);
+    EnsureFeedbackThread();
+    FeedbackMailbox m = {0};
+    m.state.x = (short)anchor.x;
+    m.state.y = (short)anchor.y;
+    m.state.visible = 1;
+    m.state.cursor = CURSOR_ALL;
+    PostFeedback(m);
+    HANDLE hThread = CreateThread(NULL, 0, ScrollingThread, NULL, 0, NULL);
+    if (hThread) CloseHandle(hThread);
 }
 
-void StartScrolling()
+void StopScrolling()
 {
-    if (g_scrollState == STATE_IDLE || g_scrollState == STATE_PRIMED)
+    if (g_scrollState == STATE_SCROLLING)
     {
-        if (g_scrollState == STATE_IDLE)
-            GetCursorPos(&g_startScrollPos);
-        else
-            g_startScrollPos = g_primeStartPos;
-        g_hTargetWnd = WindowFromPoint(g_startScrollPos);
-        g_scrollState = STATE_SCROLLING;
-        SetScrollCursor(CURSOR_ALL);
-        if (g_config.show_indicator) RenderAndShowOverlay(g_startScrollPos);
-        HANDLE hThread = CreateThread(NULL, 0, ScrollingThread, NULL, 0, NULL);
-        if (hThread) CloseHandle(hThread);
+        EndScrolling();
+        FeedbackMailbox hidden = {0};
+        PostFeedback(hidden);
+        // Flurries of short gestures share one write
+        if (g_config.fun_stats)
+            SetTimer(g_hMainWnd, ID_TIMER_SAVE_STATS, SAVE_STATS_DELAY_MS,
+                     NULL);
+        ScheduleIdleTrim();
     }
 }
 
-void StopScrolling()
+void SetPaused(BOOL paused)
 {
-    if (g_scrollState == STATE_SCROLLING)
+    g_isPaused = paused;
+    if (paused) StopScrolling();
+    UpdateTrayIconState();
+}
+
+// False if there is no config.ini to reload
+bool ReloadConfig()
+{
+    if (GetFileAttributes("config.ini") == INVALID_FILE_ATTRIBUTES)
+        return false;
+    // Save what the delayed save still holds, or re-reading the stats
+    // below would drop it
+    if (KillTimer(g_hMainWnd, ID_TIMER_SAVE_STATS))
     {
-        HideOverlay();
-        g_scrollState = STATE_STOPPING;
         if (g_config.fun_stats) SaveStats();
+        SaveCalibrations();
+    }
+    LoadConfig("config.ini");
+    OpenTrace(g_config.trace_file, Win32Now);
+    RefreshMonitorScales();
+    OpenAssetPack();
+    LoadStats();
+    ReloadCursors();
+    ScheduleIdleTrim();
+    return true;
+}
+
+void ApplyTriggerAction(TriggerAction a)
+{
+    switch (a)
+    {
+    case ACTION_START:
+        StartScrolling();
+        break;
+    case ACTION_STOP:
+        StopScrolling();
+        break;
+    case ACTION_CLICK:
+    {
+        // Replay the press of whichever button primed the gesture
+        DWORD downFlag = MOUSEEVENTF_MIDDLEDOWN, upFlag = MOUSEEVENTF_MIDDLEUP;
+        DWORD data = 0;
+        switch (g_triggers.bindings[g_activeBinding].button)
+        {
+        case TRIGGER_BUTTON_LEFT:
+            downFlag = MOUSEEVENTF_LEFTDOWN;
+            upFlag = MOUSEEVENTF_LEFTUP;
+            break;
+        case TRIGGER_BUTTON_RIGHT:
+            downFlag = MOUSEEVENTF_RIGHTDOWN;
+            upFlag = MOUSEEVENTF_RIGHTUP;
+            break;
+        case TRIGGER_BUTTON_X1:
+        case TRIGGER_BUTTON_X2:
+            downFlag = MOUSEEVENTF_XDOWN;
+            upFlag = MOUSEEVENTF_XUP;
+            data = g_triggers.bindings[g_activeBinding].button ==
+                           TRIGGER_BUTTON_X1
+                       ? XBUTTON1
+                       : XBUTTON2;
+            break;
+        }
+        InputBatch batch = {0};
+        BatchMouseInput(&batch, downFlag, data);
+        BatchMouseInput(&batch, upFlag, data);
+        FlushInputBatch(&batch);
+        break;
+    }
+    default:
+        break;
     }
 }
 
 // --- Hooks & Thread ---
+int TriggerButtonFromMessage(WPARAM wParam, const MSLLHOOKSTRUCT* p,
+                             bool* down)
+{
+    *down = wParam == WM_LBUTTONDOWN || wParam == WM_RBUTTONDOWN ||
+            wParam == WM_MBUTTONDOWN || wParam == WM_XBUTTONDOWN;
+    switch (wParam)
+    {
+    case WM_LBUTTONDOWN:
+    case WM_LBUTTONUP:
+        return TRIGGER_BUTTON_LEFT;
+    case WM_RBUTTONDOWN:
+    case WM_RBUTTONUP:
+        return TRIGGER_BUTTON_RIGHT;
+    case WM_MBUTTONDOWN:
+    case WM_MBUTTONUP:
+        return TRIGGER_BUTTON_MIDDLE;
+    case WM_XBUTTONDOWN:
+    case WM_XBUTTONUP:
+        return HIWORD(p->mouseData) == XBUTTON1 ? TRIGGER_BUTTON_X1
+                                                : TRIGGER_BUTTON_X2;
+    default:
+        return 0;
+    }
+}
+
+int HeldModifiers()
+{
+    int m = 0;
+    if (GetAsyncKeyState(VK_CONTROL) & 0x8000) m |= CHORD_CTRL;
+    if (GetAsyncKeyState(VK_SHIFT) & 0x8000) m |= CHORD_SHIFT;
+    if (GetAsyncKeyState(VK_MENU) & 0x8000) m |= CHORD_ALT;
+    if ((GetAsyncKeyState(VK_LWIN) | GetAsyncKeyState(VK_RWIN)) & 0x8000)
+        m |= CHORD_WIN;
+    return m;
+}
+
 LRESULT CALLBACK LowLevelMouseProc(int nCode, WPARAM wParam, LPARAM lParam)
 {
+    unsigned long long begin = FlightNow();
     if (nCode == HC_ACTION)
     {
         MSLLHOOKSTRUCT* pMouse = (MSLLHOOKSTRUCT*)lParam;
-        if (pMouse->flags & LLMHF_INJECTED)
+        // Our own wheel input passes untouched. Input other programs
+        // inject (button remappers, accessibility tools) is handled like
+        // the hardware's, so a remapped button can be a trigger too.
+        if ((pMouse->flags & LLMHF_INJECTED) &&
+            pMouse->dwExtraInfo == WAS_INPUT_SIGNATURE)
             return CallNextHookEx(g_hMouseHook, nCode, wParam, lParam);
 
-        if (!g_isPaused && g_config.trigger_middle_mouse)
+        bool down;
+        int button = TriggerButtonFromMessage(wParam, pMouse, &down);
+        if (!g_isPaused && (button & g_triggers.buttonMask))
         {
-            if (wParam == WM_MBUTTONDOWN)
+            int binding =
+                down ? FindButtonBinding(&g_triggers, button, HeldModifiers())
+                     : -1;
+            if (down && binding >= 0)
             {
-                PostMessage(g_hMainWnd, WM_APP_MBUTTON_DOWN, 0, 0);
+                if (g_scrollState == STATE_IDLE)
+                    ArmDragGate(&g_hookDrag, pMouse->pt.x, pMouse->pt.y,
+                                MotionAt(pMouse->pt)->drag_threshold);
+                PressHeldButton(&g_hookHeld, button, binding);
+                PostMessage(g_hMainWnd, WM_APP_BUTTON_DOWN, binding,
+                            MAKELPARAM(pMouse->pt.x, pMouse->pt.y));
+                FlightSpan(FLIGHT_HOOK_MOUSE, (int)wParam, begin);
                 return 1;
             }
-            if (wParam == WM_MOUSEMOVE && g_scrollState == STATE_PRIMED)
-            {
-                PostMessage(g_hMainWnd, WM_APP_MOUSE_MOVE, 0, 0);
-            }
-            if (wParam == WM_MBUTTONUP)
+            if (!down && ReleaseHeldButton(&g_hookHeld, button, &binding))
             {
-                if (g_scrollState == STATE_PRIMED ||
-                    g_scrollState == STATE_SCROLLING)
+                if (binding >= 0)
                 {
-                    PostMessage(g_hMainWnd, WM_APP_MBUTTON_UP, 0, 0);
-                    return 1;
+                    DisarmDragGate(&g_hookDrag);
+                    PostMessage(g_hMainWnd, WM_APP_BUTTON_UP, binding, 0);
                 }
+                FlightSpan(FLIGHT_HOOK_MOUSE, (int)wParam, begin);
+                return 1;
             }
         }
+        if (wParam == WM_MOUSEMOVE &&
+            CrossDragGate(&g_hookDrag, pMouse->pt.x, pMouse->pt.y))
+        {
+            PostMessage(g_hMainWnd, WM_APP_DRAG_START, 0,
+                        MAKELPARAM(pMouse->pt.x, pMouse->pt.y));
+        }
+        if (wParam == WM_MOUSEMOVE && g_scrollState == STATE_SCROLLING &&
+            IsPanGesture())
+        {
+            HookPoint p;
+            p.pt = pMouse->pt;
+            g_hookPointer.store(p.bits);
+            SetEvent(g_hPointerMoved);
+        }
     }
+    // Idle pointer motion is the bulk of all hook calls and does nothing;
+    // keep it out of the ring so it does not crowd out older gestures.
+    if (wParam != WM_MOUSEMOVE || g_scrollState != STATE_IDLE)
+        FlightSpan(FLIGHT_HOOK_MOUSE, (int)wParam, begin);
     return CallNextHookEx(g_hMouseHook, nCode, wParam, lParam);
 }
 
 LRESULT CALLBACK LowLevelKeyboardProc(int nCode, WPARAM wParam, LPARAM lParam)
 {
-    if (nCode == HC_ACTION && !g_isPaused)
+    unsigned long long begin = FlightNow();
+    PKBDLLHOOKSTRUCT p = (PKBDLLHOOKSTRUCT)lParam;
+    // One bit test drops every key that is neither a trigger nor cancel
+    if (nCode == HC_ACTION && !g_isPaused &&
+        IsTriggerKey(&g_triggers, p->vkCode))
     {
-        PKBDLLHOOKSTRUCT p = (PKBDLLHOOKSTRUCT)lParam;
-        if (wParam == WM_KEYDOWN && p->vkCode == VK_ESCAPE &&
+        bool down = wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN;
+        int vk = (int)p->vkCode;
+        if (down && vk == g_config.cancel_vk_code &&
             (g_scrollState == STATE_SCROLLING || g_scrollState == STATE_PRIMED))
         {
             PostMessage(g_hMainWnd, WM_APP_CANCEL, 0, 0);
+            FlightSpan(FLIGHT_HOOK_KEYBOARD, vk, begin);
             return 1;
         }
-        if (g_config.trigger_vk_code != 0 &&
-            p->vkCode == g_config.trigger_vk_code)
+        // Cruise keys are only taken while scrolling, nudges only while
+        // cruising
+        if (down && g_scrollState == STATE_SCROLLING)
         {
-            if (wParam == WM_KEYDOWN)
-                PostMessage(g_hMainWnd, WM_APP_KEY_DOWN, 0, 0);
-            else if (wParam == WM_KEYUP)
-                PostMessage(g_hMainWnd, WM_APP_KEY_UP, 0, 0);
+            int nudge = vk == g_config.cruise_faster_vk_code   ? 1
+                        : vk == g_config.cruise_slower_vk_code ? -1
+                                                               : 0;
+            if (vk == g_config.cruise_vk_code || (nudge && IsCruising()))
+            {
+                PostMessage(g_hMainWnd, WM_APP_CRUISE, (WPARAM)nudge, 0);
+                FlightSpan(FLIGHT_HOOK_KEYBOARD, vk, begin);
+                return 1;
+            }
+        }
+        int binding = down ? FindKeyBinding(&g_triggers, vk, HeldModifiers())
+                           : FindReleasedKeyBinding(&g_triggers, vk);
+        if (binding >= 0)
+        {
+            PostMessage(g_hMainWnd, down ? WM_APP_KEY_DOWN : WM_APP_KEY_UP,
+                        binding, 0);
+            FlightSpan(FLIGHT_HOOK_KEYBOARD, vk, begin);
             if (!g_config.keyboard_passthrough) return 1;
         }
     }
@@ -498,219 +816,703 @@ LRESULT CALLBACK LowLevelKeyboardProc(int nCode, WPARAM wParam, LPARAM lParam)
 
 DWORD WINAPI ScrollingThread(LPVOID lpParameter)
 {
-    while (g_scrollState == STATE_SCROLLING)
+    HANDLE hTask = EnterRealtime();
+    // Decoupled mode: this thread only samples, EmitterThread emits.
+    HANDLE hEmitter = NULL;
+    PublishVelocity(0.0f, 0.0f);
+    ResetWheelFlow(&g_wheelFlow);
+    if (g_config.output_frequency > 0 && !IsPanGesture())
+        hEmitter = CreateThread(NULL, 0, EmitterThread, NULL, 0, NULL);
+
+    HANDLE hProbe = NULL;
+    if (!g_config.use_send_input_api && g_config.scroll_limit_probe_ms > 0)
     {
-        POINT currentPos;
-        GetCursorPos(&currentPos);
-        int dx = currentPos.x - g_startScrollPos.x;
-        int dy = currentPos.y - g_startScrollPos.y;
-        int vS = 0, hS = 0;
-
-        // 1. Dead Zone Check
-        bool act = false;
-        if (g_config.dead_zone_shape == SHAPE_SQUARE)
-        {
-            act =
-                (abs(dx) > g_config.dead_zone || abs(dy) > g_config.dead_zone);
-        }
-        else
+        if (!g_hLimitProbeStop)
+            g_hLimitProbeStop = CreateEvent(NULL, TRUE, FALSE, NULL);
+        ResetEvent(g_hLimitProbeStop);
+        hProbe = CreateThread(NULL, 0, LimitProbeThread, NULL, 0, NULL);
+    }
+
+    // Calibration: the gesture's own wheel messages are the test burst
+    ScrollSnapshot before;
+    HWND vBar = g_measureTarget ? FindScrollBarOwner(g_hTargetWnd, SB_VERT)
+                                : NULL;
+    if (!TakeScrollSnapshot(vBar, &before)) vBar = NULL;
+    InterlockedExchange(&g_gestureWheelV, 0);
+
+    RunSampler(&g_win32Backend, hEmitter != NULL);
+
+    if (hEmitter)
+    {
+        WaitForSingleObject(hEmitter, INFINITE);
+        CloseHandle(hEmitter);
+    }
+    if (hProbe)
+    {
+        SetEvent(g_hLimitProbeStop);
+        WaitForSingleObject(hProbe, INFINITE);
+        CloseHandle(hProbe);
+    }
+    if (vBar) MeasureTarget(vBar, &before);
+    ResetWheelFlow(&g_wheelFlow); // drop any backlog still held back
+    if (hTask) AvRevertMmThreadCharacteristics(hTask);
+    FlightReleaseThread();
+    g_scrollState = STATE_IDLE;
+    return 0;
+}
+
+DWORD WINAPI EmitterThread(LPVOID lpParameter)
+{
+    HANDLE hTask = EnterRealtime();
+    RunEmitter(&g_win32Backend);
+    if (hTask) AvRevertMmThreadCharacteristics(hTask);
+    FlightReleaseThread();
+    return 0;
+}
+
+// realtime_scheduling: raises the calling scroll thread so background load
+// cannot delay its ticks. MMCSS keeps some CPU for the rest of the system;
+// without it the thread runs time-critical. Scroll threads live for one
+// gesture, so only the returned MMCSS handle needs undoing.
+HANDLE EnterRealtime()
+{
+    if (!g_config.realtime_scheduling)
+    {
+        g_realtime = 0;
+        return NULL;
+    }
+    DWORD taskIndex = 0;
+    HANDLE task = AvSetMmThreadCharacteristics("Games", &taskIndex);
+    BOOL raised =
+        task || SetThreadPriority(GetCurrentThread(),
+                                  THREAD_PRIORITY_TIME_CRITICAL);
+    int core = g_config.realtime_core;
+    if (core >= 0 && core < (int)sizeof(DWORD_PTR) * 8)
+        SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << core);
+    g_realtime = raised ? 1 : -1;
+    return task;
+}
+
+void EnsureFeedbackThread()
+{
+    if (g_hFeedbackWake) return;
+    g_hFeedbackWake = CreateEvent(NULL, FALSE, FALSE, NULL);
+    HANDLE hThread = CreateThread(NULL, 0, FeedbackThread, NULL, 0, NULL);
+    if (hThread) CloseHandle(hThread);
+}
+
+// Keeps the cursor generation, which only ReloadCursors advances
+void PostFeedback(FeedbackMailbox m)
+{
+    FeedbackMailbox old;
+    old.bits = g_feedback.load();
+    do
+    {
+        m.state.cursors = old.state.cursors;
+    } while (!g_feedback.compare_exchange_weak(old.bits, m.bits));
+    WakeFeedback();
+}
+
+// Runs on the main thread after a reload: the feedback thread drops the
+// cursors it has and loads them from the new config with the next gesture
+void ReloadCursors()
+{
+    FeedbackMailbox m, want;
+    m.bits = g_feedback.load();
+    do
+    {
+        want = m;
+        want.state.cursors++;
+    } while (!g_feedback.compare_exchange_weak(m.bits, want.bits));
+    if (g_hFeedbackWake) WakeFeedback();
+}
+
+// Latency is counted from the oldest post the thread has not applied yet
+void WakeFeedback()
+{
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    long long none = 0;
+    g_feedbackPostedAt.compare_exchange_strong(none, now.QuadPart);
+    SetEvent(g_hFeedbackWake);
+}
+
+// Owns the overlay window, so it also pumps that window's messages.
+DWORD WINAPI FeedbackThread(LPVOID lpParameter)
+{
+    FlightNameThread("feedback");
+    FeedbackMailbox shown = {0};
+    for (;;)
+    {
+        DWORD woke = MsgWaitForMultipleObjects(1, &g_hFeedbackWake, FALSE,
+                                               INFINITE, QS_ALLINPUT);
+        MSG msg;
+        while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) DispatchMessage(&msg);
+        if (woke != WAIT_OBJECT_0) continue;
+
+        // Claim the timestamp first: a post that lands in between wakes
+        // this thread again with its own.
+        long long postedAt = g_feedbackPostedAt.exchange(0);
+        FeedbackMailbox want;
+        want.bits = g_feedback.load();
+        ApplyFeedback(&shown, want);
+        RecordFeedbackLatency(postedAt);
+    }
+    return 0;
+}
+
+void ApplyFeedback(FeedbackMailbox* shown, FeedbackMailbox want)
+{
+    if (want.state.cursors != shown->state.cursors) FreeCursors();
+    if (want.state.visible)
+    {
+        bool moved = !shown->state.visible || shown->state.x != want.state.x ||
+                     shown->state.y != want.state.y;
+        if (!g_cursorsLoaded) LoadCursors();
+        SetScrollCursor((ScrollCursorType)want.state.cursor);
+        if (moved && g_config.show_indicator)
         {
-            act =
-                (sqrt((double)dx * dx + (double)dy * dy) > g_config.dead_zone);
+            POINT center = {want.state.x, want.state.y};
+            RenderAndShowOverlay(center);
         }
+    }
+    else if (shown->state.visible)
+    {
+        HideOverlay();
+        RestoreSystemCursors();
+    }
+    *shown = want;
+}
 
-        if (act)
-        {
-            // 2. Calculate Raw Magnitude
-            vS = CalculateScrollAmount(dy, g_config.emulate_touchpad_scrolling);
-            hS = CalculateScrollAmount(dx, g_config.emulate_touchpad_scrolling);
+void RecordFeedbackLatency(long long postedAt)
+{
+    if (!postedAt) return;
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    double ms = (double)(now.QuadPart - postedAt) * 1000.0 /
+                (double)freq.QuadPart;
+    g_feedbackUpdates++;
+    g_feedbackLatencyTotalMs += ms;
+    if (ms > g_feedbackLatencyMaxMs) g_feedbackLatencyMaxMs = ms;
+}
 
-            // 3. Axis Locking
-            if (g_config.axis_lock_threshold > 0)
-            {
-                int adx = abs(dx);
-                int ady = abs(dy);
-                if (ady >= adx)
-                {
-                    if (adx <= g_config.axis_lock_threshold) hS = 0;
-                }
-                else
-                {
-                    if (ady <= g_config.axis_lock_threshold) vS = 0;
-                }
-            }
+// --- Control Channel ---
+// Full access for this user and SYSTEM only, rather than the default DACL
+// that also lets Everyone read; LocalFree the result. NULL on failure.
+PSECURITY_DESCRIPTOR ControlPipeSecurity()
+{
+    HANDLE token;
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_QUERY, &token))
+        return NULL;
+    DWORD buffer[64]; // TOKEN_USER and the SID it points to
+    DWORD size = 0;
+    char* sid = NULL;
+    PSECURITY_DESCRIPTOR sd = NULL;
+    if (GetTokenInformation(token, TokenUser, buffer, sizeof(buffer), &size) &&
+        ConvertSidToStringSid(((TOKEN_USER*)buffer)->User.Sid, &sid))
+    {
+        char sddl[256];
+        _snprintf_s(sddl, sizeof(sddl), _TRUNCATE,
+                    "D:P(A;;GA;;;SY)(A;;GA;;;%s)", sid);
+        ConvertStringSecurityDescriptorToSecurityDescriptor(
+            sddl, SDDL_REVISION_1, &sd, NULL);
+        LocalFree(sid);
+    }
+    CloseHandle(token);
+    return sd;
+}
 
-            // 4. Natural Scrolling
-            if (g_config.natural_scrolling)
+// Serves the control pipe one client at a time. Snapshots are answered
+// here; anything that changes state runs on the main thread.
+DWORD WINAPI ControlThread(LPVOID lpParameter)
+{
+    DWORD session = 0;
+    ProcessIdToSessionId(GetCurrentProcessId(), &session);
+    char name[64];
+    ControlPipeName(name, sizeof(name), session);
+    SECURITY_ATTRIBUTES sa = {sizeof(sa), ControlPipeSecurity(), FALSE};
+    if (!sa.lpSecurityDescriptor) return 1;
+
+    // First instance only, so no other process can squat on the name. The
+    // one instance is reused for every client.
+    HANDLE pipe = CreateNamedPipe(
+        name, PIPE_ACCESS_DUPLEX | FILE_FLAG_FIRST_PIPE_INSTANCE,
+        PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT |
+            PIPE_REJECT_REMOTE_CLIENTS,
+        1, sizeof(ControlReply), sizeof(ControlRequest), 0, &sa);
+    LocalFree(sa.lpSecurityDescriptor);
+    if (pipe == INVALID_HANDLE_VALUE) return 1;
+    for (;;)
+    {
+        if (ConnectNamedPipe(pipe, NULL) ||
+            GetLastError() == ERROR_PIPE_CONNECTED)
+        {
+            ControlRequest req;
+            ControlReply reply;
+            DWORD n = 0;
+            if (ReadFile(pipe, &req, sizeof(req), &n, NULL) &&
+                n == sizeof(req))
             {
-                vS = -vS;
-                hS = -hS;
+                if (BeginControlReply(&req, &reply))
+                    HandleControlRequest(&req, &reply);
+                WriteFile(pipe, &reply, sizeof(reply), &n, NULL);
+                FlushFileBuffers(pipe);
             }
+        }
+        DisconnectNamedPipe(pipe);
+    }
+}
 
-            // 5. Wheel Inversion (Standard Line Scrolling needs this)
-            if (!g_config.emulate_touchpad_scrolling) vS = -vS;
+void HandleControlRequest(const ControlRequest* req, ControlReply* reply)
+{
+    switch (req->command)
+    {
+    case CONTROL_PAUSE:
+    case CONTROL_RESUME:
+    case CONTROL_RELOAD:
+    {
+        DWORD_PTR status = CONTROL_FAILED;
+        if (!SendMessageTimeout(g_hMainWnd, WM_APP_CONTROL, req->command, 0,
+                                SMTO_ABORTIFHUNG, 5000, &status))
+            status = CONTROL_FAILED;
+        reply->status = (unsigned int)status;
+        break;
+    }
+    case CONTROL_STATS:
+        reply->stats = g_stats;
+        reply->status = CONTROL_OK;
+        break;
+    case CONTROL_METRICS:
+        FillControlMetrics(&reply->metrics);
+        reply->status = CONTROL_OK;
+        break;
+    case CONTROL_DUMP_TRACE:
+        PathNextToExe(reply->path, "flight-trace.json");
+        reply->status = DumpFlightTrace(reply->path) ? CONTROL_OK
+                                                     : CONTROL_FAILED;
+        break;
+    }
+}
 
-            // 6. Apply Input
-            if (g_config.use_send_input_api)
-            {
-                // Option A: Global Hardware Emulation (Follows Mouse)
-                if (vS != 0) SendMouseInput(MOUSEEVENTF_WHEEL, (DWORD)vS);
-                if (hS != 0) SendMouseInput(MOUSEEVENTF_HWHEEL, (DWORD)hS);
-            }
-            else
-            {
-                // Option B: Targeted Message (Locks to Anchor Window)
-                LPARAM lp = ((DWORD)g_startScrollPos.x & 0xFFFF) |
-                            ((DWORD)g_startScrollPos.y << 16);
+// Runs on the main thread (WM_APP_CONTROL)
+ControlStatus RunControlCommand(ControlCommand c)
+{
+    switch (c)
+    {
+    case CONTROL_PAUSE:
+    case CONTROL_RESUME:
+        SetPaused(c == CONTROL_PAUSE);
+        return CONTROL_OK;
+    case CONTROL_RELOAD:
+        return ReloadConfig() ? CONTROL_OK : CONTROL_FAILED;
+    default:
+        return CONTROL_UNSUPPORTED;
+    }
+}
 
-                if (vS != 0)
-                {
-                    WPARAM wp = MAKEWPARAM(0, (short)vS);
-                    PostMessage(g_hTargetWnd, WM_MOUSEWHEEL, wp, lp);
-                }
-                if (hS != 0)
-                {
-                    WPARAM wp = MAKEWPARAM(0, (short)hS);
-                    PostMessage(g_hTargetWnd, WM_MOUSEHWHEEL, wp, lp);
-                }
-            }
+void FillControlMetrics(ControlMetrics* m)
+{
+    PROCESS_MEMORY_COUNTERS pmc = {0};
+    pmc.cb = sizeof(pmc);
+    GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc));
+    LONG updates = g_feedbackUpdates;
+    m->paused = g_isPaused;
+    m->scroll_state = g_scrollState;
+    m->startup_ms = g_startupMs;
+    m->working_set = pmc.WorkingSetSize;
+    m->peak_working_set = pmc.PeakWorkingSetSize;
+    m->private_bytes = pmc.PagefileUsage; // commit charge, as in the tray
+    m->feedback_updates = updates;
+    m->feedback_latency_avg_ms =
+        updates ? g_feedbackLatencyTotalMs / updates : 0.0;
+    m->feedback_latency_max_ms = g_feedbackLatencyMaxMs;
+    m->realtime = g_realtime;
+    FillTickLatency(m);
+    m->gesture_input_calls = (unsigned long long)g_gestureSendInputCalls;
+}
 
-            // 7. Stats
-            if (g_config.fun_stats)
-            {
-                unsigned long long moved = abs(vS) + abs(hS);
-                g_stats.total_pixels += moved;
-                g_stats.session_pixels += moved;
-
-                int logicalVs = g_config.emulate_touchpad_scrolling ? -vS : vS;
-                if (g_config.natural_scrolling) logicalVs = -logicalVs;
-                int logicalHs = g_config.natural_scrolling ? -hS : hS;
-
-                if (logicalVs > 0) g_stats.dir_up += logicalVs;
-                if (logicalVs < 0) g_stats.dir_down += abs(logicalVs);
-                if (logicalHs > 0) g_stats.dir_right += logicalHs;
-                if (logicalHs < 0) g_stats.dir_left += abs(logicalHs);
-            }
-        }
+// path: MAX_PATH chars
+void PathNextToExe(char* path, const char* name)
+{
+    strcpy_s(path, MAX_PATH, g_statsPath);
+    char* slash = strrchr(path, '\\');
+    if (slash) *(slash + 1) = 0;
+    strcat_s(path, MAX_PATH, name);
+}
 
-        // --- Cursor Update Logic ---
-        ScrollCursorType target = CURSOR_ALL;
-        if (act)
+// Samples the target's scroll bars at a low rate so EmitScroll can skip
+// directions that would not move anything. The owning windows are looked
+// up once per gesture.
+DWORD WINAPI LimitProbeThread(LPVOID lpParameter)
+{
+    FlightNameThread("limit probe");
+    HWND vBar = FindScrollBarOwner(g_hTargetWnd, SB_VERT);
+    HWND hBar = FindScrollBarOwner(g_hTargetWnd, SB_HORZ);
+    if (vBar || hBar)
+    {
+        do
         {
-            bool lockedVertically = false;
-            bool lockedHorizontally = false;
+            unsigned long long begin = FlightNow();
+            LONG limits = ProbeScrollBar(vBar, SB_VERT, LIMIT_TOP,
+                                         LIMIT_BOTTOM) |
+                          ProbeScrollBar(hBar, SB_HORZ, LIMIT_LEFT,
+                                         LIMIT_RIGHT);
+            InterlockedExchange(&g_scrollLimits, limits);
+            FlightSpan(FLIGHT_LIMIT_PROBE, limits, begin);
+        } while (WaitForSingleObject(g_hLimitProbeStop,
+                                     g_config.scroll_limit_probe_ms) ==
+                 WAIT_TIMEOUT);
+    }
+    InterlockedExchange(&g_scrollLimits, 0);
+    FlightReleaseThread();
+    return 0;
+}
 
-            if (g_config.axis_lock_threshold > 0)
-            {
-                int adx = abs(dx);
-                int ady = abs(dy);
-                if (ady >= adx)
-                {
-                    if (adx <= g_config.axis_lock_threshold)
-                        lockedVertically = true;
-                }
-                else
-                {
-                    if (ady <= g_config.axis_lock_threshold)
-                        lockedHorizontally = true;
-                }
-            }
+// Wheel messages bubble up to the parent, so the nearest window with a
+// standard scroll bar on that axis is the one that moves.
+HWND FindScrollBarOwner(HWND hWnd, int bar)
+{
+    DWORD style = bar == SB_VERT ? WS_VSCROLL : WS_HSCROLL;
+    for (; hWnd; hWnd = GetAncestor(hWnd, GA_PARENT))
+    {
+        LONG windowStyle = GetWindowLong(hWnd, GWL_STYLE);
+        SCROLLINFO si = {sizeof(SCROLLINFO), SIF_RANGE};
+        if ((windowStyle & style) && GetScrollInfo(hWnd, bar, &si))
+            return hWnd;
+        if (!(windowStyle & WS_CHILD)) break;
+    }
+    return NULL;
+}
 
-            if (lockedVertically)
-                target = CURSOR_NS;
-            else if (lockedHorizontally)
-                target = CURSOR_WE;
-            else
-            {
-                double angle = atan2((double)dy, (double)dx) * 180.0 / M_PI;
-                if (fabs(angle) <= 22.5 || fabs(angle) >= 157.5)
-                    target = CURSOR_WE;
-                else if (fabs(angle) >= 67.5 && fabs(angle) <= 112.5)
-                    target = CURSOR_NS;
-                else
-                {
-                    if ((dx > 0 && dy > 0) || (dx < 0 && dy < 0))
-                        target = CURSOR_NWSE;
-                    else
-                        target = CURSOR_NESW;
-                }
-            }
-        }
-        if (g_currentCursorType != target) SetScrollCursor(target);
+LONG ProbeScrollBar(HWND hWnd, int bar, LONG low, LONG high)
+{
+    SCROLLINFO si = {sizeof(SCROLLINFO), SIF_POS | SIF_PAGE | SIF_RANGE};
+    if (!hWnd || !GetScrollInfo(hWnd, bar, &si)) return 0;
+    int page = si.nPage ? (int)si.nPage : 1;
+    LONG limits = 0;
+    if (si.nPos <= si.nMin) limits |= low;
+    if (si.nPos + page - 1 >= si.nMax) limits |= high;
+    return limits;
+}
 
-        int freq = g_config.update_frequency;
-        if (freq <= 0) freq = 60;
-        Sleep(1000 / freq);
+// "process.exe|WindowClass" of the window wheel messages go to
+void TargetKey(HWND hWnd, char* key, size_t size)
+{
+    char image[MAX_PATH] = "?";
+    DWORD pid = 0;
+    GetWindowThreadProcessId(hWnd, &pid);
+    HANDLE process =
+        OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+    if (process)
+    {
+        DWORD length = MAX_PATH;
+        if (!QueryFullProcessImageName(process, 0, image, &length))
+            strcpy_s(image, "?");
+        CloseHandle(process);
     }
-    RestoreSystemCursors();
-    g_scrollState = STATE_IDLE;
+    const char* name = strrchr(image, '\\');
+    char className[64] = "";
+    GetClassName(hWnd, className, sizeof(className));
+    _snprintf_s(key, size, _TRUNCATE, "%s|%s", name ? name + 1 : image,
+                className);
+}
+
+bool TakeScrollSnapshot(HWND hWnd, ScrollSnapshot* s)
+{
+    SCROLLINFO si = {sizeof(SCROLLINFO), SIF_POS | SIF_PAGE | SIF_RANGE};
+    RECT client;
+    if (!hWnd || !GetScrollInfo(hWnd, SB_VERT, &si) || !si.nPage ||
+        !GetClientRect(hWnd, &client))
+        return false;
+    s->pos = si.nPos;
+    s->page = (int)si.nPage;
+    s->min = si.nMin;
+    s->max = si.nMax;
+    s->view_pixels = client.bottom - client.top;
+    return true;
+}
+
+// Runs on the scrolling thread once the gesture is over. The settle-wait
+// happens on a thread of its own, so the gesture can end (and the next
+// one start) right away.
+void MeasureTarget(HWND vBar, const ScrollSnapshot* before)
+{
+    int sent = g_gestureWheelV;
+    if (abs(sent) < CALIBRATION_MIN_UNITS) return;
+    TargetMeasurement* m =
+        (TargetMeasurement*)calloc(1, sizeof(TargetMeasurement));
+    if (!m) return;
+    m->vBar = vBar;
+    m->before = *before;
+    m->sent = sent;
+    m->gesture = g_gestureSerial;
+    // Still set for this gesture: the next one cannot start before idle
+    strcpy_s(m->key, g_targetKey);
+    HANDLE hThread = CreateThread(NULL, 0, MeasureThread, m, 0, NULL);
+    if (hThread)
+        CloseHandle(hThread);
+    else
+        free(m);
+}
+
+// Waits until the target has worked off the burst (smooth-scrolling apps
+// keep animating for a while), then hands the result to the main thread.
+// A gesture started meanwhile scrolls the same content, so it voids the
+// measurement.
+DWORD WINAPI MeasureThread(LPVOID lpParameter)
+{
+    TargetMeasurement* m = (TargetMeasurement*)lpParameter;
+    ScrollSnapshot last, now;
+    bool settled = TakeScrollSnapshot(m->vBar, &last);
+    for (int stable = 0, i = 0; settled && stable < 3 && i < 30; i++)
+    {
+        Sleep(15);
+        if (m->gesture != g_gestureSerial || !TakeScrollSnapshot(m->vBar, &now))
+        {
+            settled = false;
+            break;
+        }
+        stable = now.pos == last.pos ? stable + 1 : 0;
+        last = now;
+    }
+    if (settled && m->gesture == g_gestureSerial)
+        m->pixelsPerUnit = MeasureThroughput(&m->before, &last, m->sent);
+    if (m->pixelsPerUnit <= 0.0f ||
+        !PostMessage(g_hMainWnd, WM_APP_CALIBRATED, 0, (LPARAM)m))
+        free(m);
     return 0;
 }
 
-// --- Helper Funcs ---
-int CalculateScrollAmount(int delta, BOOL isTouchpad)
+// --- Win32 Backend ---
+void Win32GetPointer(int* x, int* y)
+{
+    if (IsPanGesture())
+    {
+        HookPoint p;
+        p.bits = g_hookPointer.load();
+        *x = p.pt.x;
+        *y = p.pt.y;
+        return;
+    }
+    POINT p;
+    GetCursorPos(&p);
+    *x = p.x;
+    *y = p.y;
+}
+
+double Win32Now()
+{
+    static LARGE_INTEGER freq = {0};
+    if (!freq.QuadPart) QueryPerformanceFrequency(&freq);
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return (double)now.QuadPart / (double)freq.QuadPart;
+}
+
+void Win32Wait(int ms)
+{
+    WaitPumping(NULL, ms);
+}
+
+void Win32WaitOutput(int ms)
+{
+    if (!g_config.output_vsync || FAILED(DwmFlush()))
+        WaitPumping(NULL, ms);
+    else if (g_wheelFlow.outstanding > 0)
+        PumpWheelProbes();
+}
+
+void Win32WaitInput(int ms)
+{
+    WaitPumping(g_hPointerMoved, ms);
+}
+
+void EmitScroll(int vS, int hS)
+{
+    if (g_config.use_send_input_api)
+    {
+        // Option A: Global Hardware Emulation (Follows Mouse)
+        if (vS == 0 && hS == 0) return;
+        InputBatch batch = {0};
+        if (vS != 0) BatchMouseInput(&batch, MOUSEEVENTF_WHEEL, (DWORD)vS);
+        if (hS != 0) BatchMouseInput(&batch, MOUSEEVENTF_HWHEEL, (DWORD)hS);
+        FlushInputBatch(&batch);
+        AccumulateStats(vS, hS);
+        return;
+    }
+
+    // Option B: Targeted Message (Locks to Anchor Window)
+    WheelFlow* f = &g_wheelFlow;
+    f->pendingV += vS;
+    f->pendingH += hS;
+    // Content already at its end: drop that direction instead of sending
+    // (and counting) scrolling that goes nowhere
+    LONG limits = g_scrollLimits;
+    if ((f->pendingV > 0 && (limits & LIMIT_TOP)) ||
+        (f->pendingV < 0 && (limits & LIMIT_BOTTOM)))
+        f->pendingV = 0;
+    if ((f->pendingH > 0 && (limits & LIMIT_RIGHT)) ||
+        (f->pendingH < 0 && (limits & LIMIT_LEFT)))
+        f->pendingH = 0;
+    if (f->pendingV == 0 && f->pendingH == 0) return;
+
+    // Flow control: the message that asks for an acknowledgement is sent
+    // with SendMessageCallback, which returns at once like PostMessage and
+    // calls back once the target has handled it. The callbacks run while
+    // the worker waits for its next tick (WaitPumping), so a tick costs at
+    // most WHEEL_TICK_MESSAGES calls. Only once an acknowledgement is
+    // overdue does it also ask whether the target hangs, and sends nothing
+    // more to one that does.
+    double now = Win32Now();
+    if (g_config.max_pending_messages > 0 && WheelAckOverdue(f, now) &&
+        IsHungAppWindow(g_hTargetWnd))
+        return;
+
+    WheelMessage messages[WHEEL_TICK_MESSAGES];
+    int count =
+        PlanWheelMessages(f, g_config.max_pending_messages, now, messages);
+    LPARAM lp = ((DWORD)g_startScrollPos.x & 0xFFFF) |
+                ((DWORD)g_startScrollPos.y << 16);
+    int plannedV = 0, plannedH = 0, sentV = 0;
+    for (int i = 0; i < count; i++)
+    {
+        const WheelMessage* m = &messages[i];
+        // The stats count the engine's units, the target gets them scaled
+        // by its calibration
+        if (m->horizontal)
+            plannedH += m->delta;
+        else
+            plannedV += m->delta;
+        int delta =
+            GainDelta(m->delta, m->horizontal ? &g_gainAccH : &g_gainAccV);
+        if (delta == 0)
+        {
+            if (m->ack) AckWheelMessage(f, -1.0, now);
+            continue;
+        }
+        UINT msg = m->horizontal ? WM_MOUSEHWHEEL : WM_MOUSEWHEEL;
+        WPARAM wp = MAKEWPARAM(0, (short)delta);
+        unsigned long long begin = FlightNow();
+        if (m->ack)
+        {
+            LARGE_INTEGER sent;
+            QueryPerformanceCounter(&sent);
+            if (!SendMessageCallback(g_hTargetWnd, msg, wp, lp, WheelProbeAck,
+                                     (ULONG_PTR)sent.QuadPart))
+                AckWheelMessage(f, -1.0, now);
+        }
+        else
+        {
+            PostMessage(g_hTargetWnd, msg, wp, lp);
+        }
+        FlightSpan(FLIGHT_POST_MESSAGE, delta, begin);
+        if (!m->horizontal) sentV += delta;
+    }
+    AccumulateStats(plannedV, plannedH);
+    g_gestureWheelV += sentV;
+}
+
+// Scales a planned delta by g_targetGain. The fraction, and whatever does
+// not fit one message, is carried into the next one on that axis.
+int GainDelta(int delta, double* carry)
+{
+    *carry += delta * (double)g_targetGain;
+    double fits = *carry < -32767.0  ? -32767.0
+                  : *carry > 32767.0 ? 32767.0
+                                     : *carry;
+    int out = (int)fits;
+    *carry -= out;
+    return out;
+}
+
+VOID CALLBACK WheelProbeAck(HWND hWnd, UINT msg, ULONG_PTR sentAt,
+                            LRESULT result)
+{
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    AckWheelMessage(&g_wheelFlow,
+                    (double)(now.QuadPart - (LONGLONG)sentAt) /
+                        (double)freq.QuadPart,
+                    (double)now.QuadPart / (double)freq.QuadPart);
+}
+
+// Probe callbacks are only delivered while the sending thread pumps.
+void PumpWheelProbes()
 {
-    if (delta == 0) return 0;
-    double val = pow(abs(delta) * g_config.sensitivity, g_config.ramp_exponent);
-    int res = (int)val;
-    if (res < g_config.min_scroll) res = g_config.min_scroll;
-    if (val > g_config.max_scroll) val = (double)g_config.max_scroll;
-    return (delta < 0 ? -res : res);
+    MSG msg;
+    while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) DispatchMessage(&msg);
 }
 
-void SendMouseInput(DWORD flags, DWORD mouseData)
+// Sleep (or wait for the event) that pumps whatever arrives meanwhile, so
+// wheel acknowledgements are collected between ticks instead of on them
+void WaitPumping(HANDLE event, int ms)
+{
+    double until = Win32Now() + ms / 1000.0;
+    for (;;)
+    {
+        double left = until - Win32Now();
+        DWORD timeout = left > 0.0 ? (DWORD)(left * 1000.0 + 0.5) : 0;
+        DWORD woke = MsgWaitForMultipleObjects(event ? 1 : 0, &event, FALSE,
+                                               timeout, QS_ALLINPUT);
+        if (woke != WAIT_OBJECT_0 + (event ? 1 : 0)) break;
+        PumpWheelProbes();
+        if (timeout == 0) break;
+    }
+    // An acknowledgement that raced the timeout still counts for this tick
+    if (g_wheelFlow.outstanding > 0) PumpWheelProbes();
+}
+
+// --- Helper Funcs ---
+void BatchMouseInput(InputBatch* b, DWORD flags, DWORD mouseData)
 {
-    INPUT input = {0};
-    input.type = INPUT_MOUSE;
-    input.mi.dwFlags = flags;
-    input.mi.mouseData = mouseData;
-    SendInput(1, &input, sizeof(INPUT));
+    if (b->count == ARRAYSIZE(b->inputs)) FlushInputBatch(b);
+    INPUT* input = &b->inputs[b->count++];
+    ZeroMemory(input, sizeof(INPUT));
+    input->type = INPUT_MOUSE;
+    input->mi.dwFlags = flags;
+    input->mi.mouseData = mouseData;
+    input->mi.dwExtraInfo = WAS_INPUT_SIGNATURE;
 }
 
-char* Trim(char* str)
+void FlushInputBatch(InputBatch* b)
 {
-    char* end;
-    while (isspace((unsigned char)*str)) str++;
-    if (*str == 0) return str;
-    end = str + strlen(str) - 1;
-    while (end > str && isspace((unsigned char)*end)) end--;
-    *(end + 1) = 0;
-    return str;
+    if (b->count == 0) return;
+    unsigned long long begin = FlightNow();
+    SendInput(b->count, b->inputs, sizeof(INPUT));
+    FlightSpan(FLIGHT_SEND_INPUT, b->count, begin);
+    InterlockedIncrement(&g_gestureSendInputCalls);
+    b->count = 0;
 }
 
 // --- Stats & Clipboard ---
 void LoadStats()
 {
-    char buf[32];
-    GetPrivateProfileString("Stats", "TotalPixels", "0", buf, 32, g_statsPath);
-    g_stats.total_pixels = strtoull(buf, NULL, 10);
-    GetPrivateProfileString("Stats", "Up", "0", buf, 32, g_statsPath);
-    g_stats.dir_up = strtoull(buf, NULL, 10);
-    GetPrivateProfileString("Stats", "Down", "0", buf, 32, g_statsPath);
-    g_stats.dir_down = strtoull(buf, NULL, 10);
-    GetPrivateProfileString("Stats", "Left", "0", buf, 32, g_statsPath);
-    g_stats.dir_left = strtoull(buf, NULL, 10);
-    GetPrivateProfileString("Stats", "Right", "0", buf, 32, g_statsPath);
-    g_stats.dir_right = strtoull(buf, NULL, 10);
-    GetPrivateProfileString("Stats", "Unuploaded", "0", buf, 32, g_statsPath);
-    g_stats.session_pixels = strtoull(buf, NULL, 10);
+    ReadStatsFile(g_statsPath, &g_stats);
 }
 
 void SaveStats()
 {
-    char buf[32];
-    sprintf_s(buf, "%llu", g_stats.total_pixels);
-    WritePrivateProfileString("Stats", "TotalPixels", buf, g_statsPath);
-    sprintf_s(buf, "%llu", g_stats.dir_up);
-    WritePrivateProfileString("Stats", "Up", buf, g_statsPath);
-    sprintf_s(buf, "%llu", g_stats.dir_down);
-    WritePrivateProfileString("Stats", "Down", buf, g_statsPath);
-    sprintf_s(buf, "%llu", g_stats.dir_left);
-    WritePrivateProfileString("Stats", "Left", buf, g_statsPath);
-    sprintf_s(buf, "%llu", g_stats.dir_right);
-    WritePrivateProfileString("Stats", "Right", buf, g_statsPath);
-    sprintf_s(buf, "%llu", g_stats.session_pixels);
-    WritePrivateProfileString("Stats", "Unuploaded", buf, g_statsPath);
+    unsigned long long begin = FlightNow();
+    WriteStatsFile(g_statsPath, &g_stats);
+    FlightSpan(FLIGHT_SAVE_STATS, 0, begin);
+}
+
+void LoadCalibrations()
+{
+    char path[MAX_PATH];
+    PathNextToExe(path, "calibration.ini");
+    ReadCalibrationFile(path, &g_calibrations);
+}
+
+void SaveCalibrations()
+{
+    if (!g_calibrationsDirty) return;
+    char path[MAX_PATH];
+    PathNextToExe(path, "calibration.ini");
+    WriteCalibrationFile(path, &g_calibrations);
+    g_calibrationsDirty = FALSE;
 }
 
 void CopyToClipboard(const char* text)
@@ -747,6 +1549,37 @@ void ShowLocalStats()
     MessageBox(g_hMainWnd, msg, "Local Stats", MB_OK);
 }
 
+void ShowResourceUsage()
+{
+    PROCESS_MEMORY_COUNTERS pmc = {0};
+    pmc.cb = sizeof(pmc);
+    GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc));
+
+    LONG updates = g_feedbackUpdates;
+    // Judged on the idle working set once a trim has measured one
+    SIZE_T idle = g_idleWorkingSet ? g_idleWorkingSet : pmc.WorkingSetSize;
+    bool within = idle <= MEMORY_BUDGET_BYTES;
+    char msg[640];
+    sprintf_s(msg,
+              "Startup: %.1f ms\n\n"
+              "Working Set: %.2f MB\n"
+              "Peak Working Set: %.2f MB\n"
+              "Idle Working Set: %.2f MB\n"
+              "Private Bytes: %.2f MB\n"
+              "Budget: %.2f MB (%s)\n\n"
+              "Overlay/Cursor Updates: %ld\n"
+              "Update Latency: %.2f ms avg, %.2f ms max\n\n"
+              "SendInput Calls (last gesture): %ld",
+              g_startupMs, pmc.WorkingSetSize / 1048576.0,
+              pmc.PeakWorkingSetSize / 1048576.0,
+              g_idleWorkingSet / 1048576.0, pmc.PagefileUsage / 1048576.0,
+              MEMORY_BUDGET_BYTES / 1048576.0, within ? "ok" : "EXCEEDED",
+              updates, updates ? g_feedbackLatencyTotalMs / updates : 0.0,
+              g_feedbackLatencyMaxMs, g_gestureSendInputCalls);
+    MessageBox(g_hMainWnd, msg, "Resource Usage",
+               MB_OK | (within ? 0 : MB_ICONWARNING));
+}
+
 void ShowUploadDialog()
 {
     SaveStats();
@@ -774,104 +1607,26 @@ void ShowUploadDialog()
     }
 }
 
-// --- Config Loading & Misc ---
-void LoadConfig(const char* filename)
+// --- Tray & Menu ---
+// Crossed-out copy of the active icon, drawn once on the first pause
+HICON CreatePausedIcon(HICON hBaseIcon)
 {
-    FILE* file;
-    if (fopen_s(&file, filename, "r") != 0 || !file) return;
+    EnsureGdiplus();
+    Bitmap* bmp = Bitmap::FromHICON(hBaseIcon);
+    if (!bmp) return NULL;
 
-    char line[256];
-    while (fgets(line, sizeof(line), file))
-    {
-        if (line[0] == '#' || line[0] == '\n') continue;
-        char* delim = strchr(line, '=');
-        if (!delim) continue;
-
-        *delim = 0;
-        char* key = Trim(line);
-        char* val = Trim(delim + 1);
-
-        if (!strcmp(key, "min_scroll"))
-            g_config.min_scroll = atoi(val);
-        else if (!strcmp(key, "max_scroll"))
-            g_config.max_scroll = atoi(val);
-        else if (!strcmp(key, "sensitivity"))
-            g_config.sensitivity = (float)atof(val);
-        else if (!strcmp(key, "ramp_exponent"))
-            g_config.ramp_exponent = (float)atof(val);
-        else if (!strcmp(key, "update_frequency"))
-            g_config.update_frequency = atoi(val);
-        else if (!strcmp(key, "trigger_middle_mouse"))
-            g_config.trigger_middle_mouse = atoi(val);
-        else if (!strcmp(key, "trigger_vk_code"))
-            g_config.trigger_vk_code = strtol(val, NULL, 0);
-        else if (!strcmp(key, "emulate_touchpad_scrolling"))
-            g_config.emulate_touchpad_scrolling = atoi(val);
-        else if (!strcmp(key, "middle_mouse_passthrough"))
-            g_config.middle_mouse_passthrough = atoi(val);
-        else if (!strcmp(key, "keyboard_passthrough"))
-            g_config.keyboard_passthrough = atoi(val);
-        else if (!strcmp(key, "drag_threshold"))
-            g_config.drag_threshold = atoi(val);
-        else if (!strcmp(key, "dead_zone"))
-            g_config.dead_zone = atoi(val);
-        else if (!strcmp(key, "axis_lock_threshold"))
-            g_config.axis_lock_threshold = atoi(val);
-        else if (!strcmp(key, "use_send_input_api"))
-            g_config.use_send_input_api = atoi(val);
-        else if (!strcmp(key, "show_indicator"))
-            g_config.show_indicator = atoi(val);
-        else if (!strcmp(key, "indicator_size"))
-            g_config.indicator_size = atoi(val);
-        else if (!strcmp(key, "indicator_cross_thickness"))
-            g_config.indicator_cross_thickness = atoi(val);
-        else if (!strcmp(key, "indicator_thickness"))
-            g_config.indicator_thickness = (float)atof(val);
-        else if (!strcmp(key, "indicator_filled"))
-            g_config.indicator_filled = atoi(val);
-        else if (!strcmp(key, "fun_stats"))
-            g_config.fun_stats = atoi(val);
-        else if (!strcmp(key, "natural_scrolling"))
-            g_config.natural_scrolling = atoi(val);
-        else if (!strcmp(key, "show_outline"))
-            g_config.show_outline = atoi(val);
-        else if (!strcmp(key, "outline_thickness"))
-            g_config.outline_thickness = (float)atof(val);
-        else if (!strcmp(key, "indicator_color"))
-        {
-            ParseHexColor(
-                val, &g_config.indicator_color_r, &g_config.indicator_color_g,
-                &g_config.indicator_color_b, &g_config.indicator_color_a);
-        }
-        else if (!strcmp(key, "outline_color"))
-        {
-            ParseHexColor(val, &g_config.outline_color_r,
-                          &g_config.outline_color_g, &g_config.outline_color_b,
-                          &g_config.outline_color_a);
-        }
-        else if (!strcmp(key, "trigger_mode"))
-        {
-            g_config.trigger_mode =
-                (_stricmp(val, "hold") == 0) ? MODE_HOLD : MODE_TOGGLE;
-        }
-        else if (!strcmp(key, "dead_zone_shape"))
-        {
-            if (_stricmp(val, "square") == 0)
-                g_config.dead_zone_shape = SHAPE_SQUARE;
-            else
-                g_config.dead_zone_shape = SHAPE_CIRCLE;
-        }
-        else if (!strcmp(key, "indicator_shape"))
-        {
-            if (_stricmp(val, "square") == 0)
-                g_config.indicator_shape = SHAPE_SQUARE;
-            else if (_stricmp(val, "cross") == 0)
-                g_config.indicator_shape = SHAPE_CROSS;
-            else
-                g_config.indicator_shape = SHAPE_CIRCLE;
-        }
-    }
-    fclose(file);
+    Graphics g(bmp);
+    g.SetSmoothingMode(SmoothingModeAntiAlias);
+    Pen redPen(Color(220, 200, 15, 30), 8);
+    int w = bmp->GetWidth();
+    int h = bmp->GetHeight();
+    g.DrawLine(&redPen, 0, 0, w, h);
+    g.DrawLine(&redPen, 0, h, w, 0);
+
+    HICON hPausedIcon = NULL;
+    bmp->GetHICON(&hPausedIcon);
+    delete bmp;
+    return hPausedIcon;
 }
 
 void UpdateTrayIconState()
@@ -882,49 +1637,32 @@ void UpdateTrayIconState()
     nid.uID = 1;
     nid.uFlags = NIF_TIP | NIF_ICON;
 
-    HMODULE hShell32 =
-        LoadLibraryEx("shell32.dll", NULL, LOAD_LIBRARY_AS_DATAFILE);
-    HICON hBaseIcon = NULL;
-    if (hShell32)
+    if (!g_hIconActive)
     {
-        hBaseIcon = (HICON)LoadImage(hShell32, MAKEINTRESOURCE(250), IMAGE_ICON,
-                                     0, 0, LR_DEFAULTSIZE);
-        FreeLibrary(hShell32);
+        HMODULE hShell32 =
+            LoadLibraryEx("shell32.dll", NULL, LOAD_LIBRARY_AS_DATAFILE);
+        if (hShell32)
+        {
+            g_hIconActive = (HICON)LoadImage(hShell32, MAKEINTRESOURCE(250),
+                                             IMAGE_ICON, 0, 0, LR_DEFAULTSIZE);
+            FreeLibrary(hShell32);
+        }
+        if (!g_hIconActive)
+            g_hIconActive = CopyIcon(LoadIcon(NULL, IDI_APPLICATION));
     }
-    if (!hBaseIcon) hBaseIcon = LoadIcon(NULL, IDI_APPLICATION);
 
     if (g_isPaused)
     {
-        Bitmap* bmp = Bitmap::FromHICON(hBaseIcon);
-        if (bmp)
-        {
-            Graphics g(bmp);
-            g.SetSmoothingMode(SmoothingModeAntiAlias);
-            Pen redPen(Color(220, 200, 15, 30), 8);
-            int w = bmp->GetWidth();
-            int h = bmp->GetHeight();
-            g.DrawLine(&redPen, 0, 0, w, h);
-            g.DrawLine(&redPen, 0, h, w, 0);
-
-            HICON hPausedIcon = NULL;
-            bmp->GetHICON(&hPausedIcon);
-            delete bmp;
-            DestroyIcon(hBaseIcon);
-            nid.hIcon = hPausedIcon;
-        }
-        else
-        {
-            nid.hIcon = hBaseIcon;
-        }
+        if (!g_hIconPaused) g_hIconPaused = CreatePausedIcon(g_hIconActive);
+        nid.hIcon = g_hIconPaused ? g_hIconPaused : g_hIconActive;
         strcpy_s(nid.szTip, "WinAutoScroll - Paused");
     }
     else
     {
-        nid.hIcon = hBaseIcon;
+        nid.hIcon = g_hIconActive;
         strcpy_s(nid.szTip, "WinAutoScroll - Active");
     }
     Shell_NotifyIcon(NIM_MODIFY, &nid);
-    DestroyIcon(nid.hIcon);
 }
 
 void AddTrayIcon()
@@ -973,6 +1711,9 @@ void ShowContextMenu()
     HMENU hConfigMenu = CreatePopupMenu();
     AppendMenu(hConfigMenu, MF_STRING, ID_MENU_EDIT_CONFIG, "Edit");
     AppendMenu(hConfigMenu, MF_STRING, ID_MENU_RELOAD, "Reload");
+    AppendMenu(hConfigMenu, MF_STRING, ID_MENU_DUMP_TRACE,
+               "Save Flight Trace");
+    AppendMenu(hConfigMenu, MF_STRING, ID_MENU_RESOURCES, "Resource Usage");
     AppendMenu(hMenu, MF_POPUP, (UINT_PTR)hConfigMenu, "Config");
 
     AppendMenu(hMenu, MF_SEPARATOR, 0, NULL);
@@ -986,6 +1727,87 @@ void ShowContextMenu()
     DestroyMenu(hMenu);
 }
 
+// Called from the main thread (paused icon) and the feedback thread
+void EnsureGdiplus()
+{
+    static SRWLOCK lock = SRWLOCK_INIT;
+    AcquireSRWLockExclusive(&lock);
+    if (!g_gdiplusToken)
+    {
+        GdiplusStartupInput gdiplusStartupInput;
+        GdiplusStartup(&g_gdiplusToken, &gdiplusStartupInput, NULL);
+    }
+    ReleaseSRWLockExclusive(&lock);
+}
+
+// Per-monitor aware, so pointer coordinates stay physical on every
+// display and each monitor reports its own DPI. Windows before 10 1703
+// fall back to system awareness (one DPI for all monitors).
+void EnablePerMonitorDpi()
+{
+    typedef BOOL(WINAPI * SetContextFn)(HANDLE);
+    SetContextFn setContext = (SetContextFn)GetProcAddress(
+        GetModuleHandle("user32.dll"), "SetProcessDpiAwarenessContext");
+    // DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2
+    if (!setContext || !setContext((HANDLE)-4)) SetProcessDPIAware();
+}
+
+// GetDpiForMonitor lives in shcore.dll (Windows 8.1+)
+int MonitorDpi(HMONITOR hMonitor)
+{
+    typedef HRESULT(WINAPI * GetDpiFn)(HMONITOR, int, UINT*, UINT*);
+    static GetDpiFn getDpi = NULL;
+    static bool resolved = false;
+    if (!resolved)
+    {
+        HMODULE shcore = LoadLibrary("shcore.dll");
+        if (shcore)
+            getDpi = (GetDpiFn)GetProcAddress(shcore, "GetDpiForMonitor");
+        resolved = true;
+    }
+    UINT dpiX, dpiY;
+    // 0 = MDT_EFFECTIVE_DPI
+    if (getDpi && getDpi(hMonitor, 0, &dpiX, &dpiY) == S_OK) return dpiX;
+    return g_fallbackMotion.dpi;
+}
+
+BOOL CALLBACK AddMonitorScale(HMONITOR hMonitor, HDC hdc, LPRECT rect,
+                              LPARAM lParam)
+{
+    if (g_monitorCount == MAX_MONITORS) return FALSE;
+    MonitorScale* m = &g_monitors[g_monitorCount++];
+    m->rect = *rect;
+    ScaleMotionProfile(&m->motion, MonitorDpi(hMonitor));
+    return TRUE;
+}
+
+void RefreshMonitorScales()
+{
+    HDC hdc = GetDC(NULL);
+    ScaleMotionProfile(&g_fallbackMotion, GetDeviceCaps(hdc, LOGPIXELSX));
+    ReleaseDC(NULL, hdc);
+    g_monitorCount = 0;
+    EnumDisplayMonitors(NULL, NULL, AddMonitorScale, 0);
+}
+
+const MotionProfile* MotionAt(POINT pt)
+{
+    for (int i = 0; i < g_monitorCount; i++)
+    {
+        if (PtInRect(&g_monitors[i].rect, pt)) return &g_monitors[i].motion;
+    }
+    return &g_fallbackMotion;
+}
+
+void ScheduleIdleTrim()
+{
+    if (g_config.idle_trim_seconds > 0)
+        SetTimer(g_hMainWnd, ID_TIMER_IDLE_TRIM,
+                 g_config.idle_trim_seconds * 1000, NULL);
+    else
+        KillTimer(g_hMainWnd, ID_TIMER_IDLE_TRIM);
+}
+
 void CreateOverlayWindow()
 {
     WNDCLASSEX wc = {sizeof(WNDCLASSEX), 0,    DefWindowProc, 0,    0,
@@ -998,23 +1820,15 @@ void CreateOverlayWindow()
                                    NULL, NULL, g_hInstance, NULL);
 }
 
-void RenderAndShowOverlay(POINT center)
+// Draws the indicator centred on an IndicatorExtent(scale) canvas
+void DrawIndicator(Graphics* g, float scale)
 {
     int s = g_config.indicator_size;
-    // Expand canvas slightly to accommodate outlines
     int padding =
         (int)(g_config.indicator_thickness + g_config.outline_thickness + 5);
-    int w = (s + padding) * 2;
-    int h = (s + padding) * 2;
-
-    HDC hdcScreen = GetDC(NULL);
-    HDC hdcMem = CreateCompatibleDC(hdcScreen);
-    HBITMAP hBitmap = CreateCompatibleBitmap(hdcScreen, w, h);
-    HBITMAP hOldBitmap = (HBITMAP)SelectObject(hdcMem, hBitmap);
-
-    Graphics g(hdcMem);
-    g.SetSmoothingMode(SmoothingModeAntiAlias);
-    g.Clear(Color(0, 0, 0, 0));
+    g->SetSmoothingMode(SmoothingModeAntiAlias);
+    g->Clear(Color(0, 0, 0, 0));
+    g->ScaleTransform(scale, scale);
 
     // Main Brush/Pen
     Color c(g_config.indicator_color_a, g_config.indicator_color_r,
@@ -1027,7 +1841,7 @@ void RenderAndShowOverlay(POINT center)
              g_config.outline_color_g, g_config.outline_color_b);
     Pen outPen(oc, g_config.outline_thickness);
 
-    int mid = w / 2;
+    int mid = s + padding;
     // Offsets for "Ring" outlines (Inner and Outer)
     float halfThick = g_config.indicator_thickness / 2.0f;
 
@@ -1036,25 +1850,25 @@ void RenderAndShowOverlay(POINT center)
     case SHAPE_SQUARE:
         if (g_config.indicator_filled)
         {
-            g.FillRectangle(&brush, mid - s, mid - s, s * 2, s * 2);
+            g->FillRectangle(&brush, mid - s, mid - s, s * 2, s * 2);
             if (g_config.show_outline)
-                g.DrawRectangle(&outPen, mid - s, mid - s, s * 2, s * 2);
+                g->DrawRectangle(&outPen, mid - s, mid - s, s * 2, s * 2);
         }
         else
         {
-            g.DrawRectangle(&pen, mid - s, mid - s, s * 2, s * 2);
+            g->DrawRectangle(&pen, mid - s, mid - s, s * 2, s * 2);
             if (g_config.show_outline)
             {
                 // Outer Border
-                g.DrawRectangle(&outPen, mid - s - halfThick,
-                                mid - s - halfThick,
-                                (s * 2) + g_config.indicator_thickness,
-                                (s * 2) + g_config.indicator_thickness);
+                g->DrawRectangle(&outPen, mid - s - halfThick,
+                                 mid - s - halfThick,
+                                 (s * 2) + g_config.indicator_thickness,
+                                 (s * 2) + g_config.indicator_thickness);
                 // Inner Border
-                g.DrawRectangle(&outPen, mid - s + halfThick,
-                                mid - s + halfThick,
-                                (s * 2) - g_config.indicator_thickness,
-                                (s * 2) - g_config.indicator_thickness);
+                g->DrawRectangle(&outPen, mid - s + halfThick,
+                                 mid - s + halfThick,
+                                 (s * 2) - g_config.indicator_thickness,
+                                 (s * 2) - g_config.indicator_thickness);
             }
         }
         break;
@@ -1062,50 +1876,77 @@ void RenderAndShowOverlay(POINT center)
         // Cross is tricky to outline perfectly "inside and out", so we just
         // draw the main cross and optionally a wireframe behind it if needed,
         // but for now standard drawing:
-        g.FillRectangle(&brush, mid - s,
-                        mid - g_config.indicator_cross_thickness, s * 2,
-                        g_config.indicator_cross_thickness * 2);
-        g.FillRectangle(&brush, mid - g_config.indicator_cross_thickness,
-                        mid - s, g_config.indicator_cross_thickness * 2, s * 2);
+        g->FillRectangle(&brush, mid - s,
+                         mid - g_config.indicator_cross_thickness, s * 2,
+                         g_config.indicator_cross_thickness * 2);
+        g->FillRectangle(&brush, mid - g_config.indicator_cross_thickness,
+                         mid - s, g_config.indicator_cross_thickness * 2,
+                         s * 2);
         if (g_config.show_outline)
         {
             // Draw outline rectangle bounds for the cross arms (Simple style)
-            g.DrawRectangle(&outPen, mid - s,
-                            mid - g_config.indicator_cross_thickness, s * 2,
-                            g_config.indicator_cross_thickness * 2);
-            g.DrawRectangle(&outPen, mid - g_config.indicator_cross_thickness,
-                            mid - s, g_config.indicator_cross_thickness * 2,
-                            s * 2);
+            g->DrawRectangle(&outPen, mid - s,
+                             mid - g_config.indicator_cross_thickness, s * 2,
+                             g_config.indicator_cross_thickness * 2);
+            g->DrawRectangle(&outPen, mid - g_config.indicator_cross_thickness,
+                             mid - s, g_config.indicator_cross_thickness * 2,
+                             s * 2);
         }
         break;
     case SHAPE_CIRCLE:
     default:
         if (g_config.indicator_filled)
         {
-            g.FillEllipse(&brush, mid - s, mid - s, s * 2, s * 2);
+            g->FillEllipse(&brush, mid - s, mid - s, s * 2, s * 2);
             if (g_config.show_outline)
-                g.DrawEllipse(&outPen, mid - s, mid - s, s * 2, s * 2);
+                g->DrawEllipse(&outPen, mid - s, mid - s, s * 2, s * 2);
         }
         else
         {
-            g.DrawEllipse(&pen, mid - s, mid - s, s * 2, s * 2);
+            g->DrawEllipse(&pen, mid - s, mid - s, s * 2, s * 2);
             if (g_config.show_outline)
             {
                 // Outer Ring
-                g.DrawEllipse(&outPen, mid - s - halfThick, mid - s - halfThick,
-                              (s * 2) + g_config.indicator_thickness,
-                              (s * 2) + g_config.indicator_thickness);
+                g->DrawEllipse(&outPen, mid - s - halfThick,
+                               mid - s - halfThick,
+                               (s * 2) + g_config.indicator_thickness,
+                               (s * 2) + g_config.indicator_thickness);
                 // Inner Ring
-                g.DrawEllipse(&outPen, mid - s + halfThick, mid - s + halfThick,
-                              (s * 2) - g_config.indicator_thickness,
-                              (s * 2) - g_config.indicator_thickness);
+                g->DrawEllipse(&outPen, mid - s + halfThick,
+                               mid - s + halfThick,
+                               (s * 2) - g_config.indicator_thickness,
+                               (s * 2) - g_config.indicator_thickness);
             }
         }
         break;
     }
+}
+
+void RenderAndShowOverlay(POINT center)
+{
+    unsigned long long begin = FlightNow();
+    if (!g_hOverlayWnd) CreateOverlayWindow();
+    // Sizes are at 96 DPI; draw at the anchor monitor's scale
+    float scale = g_motion.dpi / 96.0f;
+    int w = IndicatorExtent(scale);
+    int h = w;
+
+    HDC hdcScreen = GetDC(NULL);
+    HDC hdcMem = CreateCompatibleDC(hdcScreen);
+    // The shared pack's copy spares this session GDI+ altogether
+    HBITMAP hBitmap = SharedIndicatorBitmap(g_motion.dpi, w);
+    bool shared = hBitmap != NULL;
+    if (!shared) hBitmap = CreateCompatibleBitmap(hdcScreen, w, h);
+    HBITMAP hOldBitmap = (HBITMAP)SelectObject(hdcMem, hBitmap);
+    if (!shared)
+    {
+        EnsureGdiplus();
+        Graphics g(hdcMem);
+        DrawIndicator(&g, scale);
+    }
 
     POINT ptSrc = {0, 0};
-    POINT ptDst = {center.x - mid, center.y - mid};
+    POINT ptDst = {center.x - w / 2, center.y - h / 2};
     SIZE size = {w, h};
     BLENDFUNCTION blend = {AC_SRC_OVER, 0, 255, AC_SRC_ALPHA};
     UpdateLayeredWindow(g_hOverlayWnd, hdcScreen, &ptDst, &size, hdcMem, &ptSrc,
@@ -1116,11 +1957,15 @@ void RenderAndShowOverlay(POINT center)
     DeleteObject(hBitmap);
     DeleteDC(hdcMem);
     ReleaseDC(NULL, hdcScreen);
+    FlightSpan(FLIGHT_OVERLAY, 1, begin);
 }
 
 void HideOverlay()
 {
+    if (!g_hOverlayWnd) return;
+    unsigned long long begin = FlightNow();
     ShowWindow(g_hOverlayWnd, SW_HIDE);
+    FlightSpan(FLIGHT_OVERLAY, 0, begin);
 }
 
 HCURSOR LoadDynamicCursor(const char* file)
@@ -1132,20 +1977,38 @@ HCURSOR LoadDynamicCursor(const char* file)
 
 void LoadCursors()
 {
+    HCURSOR* slots[ASSET_CURSOR_COUNT] = {&g_hCursorNS, &g_hCursorWE,
+                                          &g_hCursorNWSE, &g_hCursorNESW};
     g_hCursorAll = LoadCursor(NULL, IDC_SIZEALL);
-    g_hCursorNS = LoadDynamicCursor("%SystemRoot%\\Cursors\\lns.cur");
-    g_hCursorWE = LoadDynamicCursor("%SystemRoot%\\Cursors\\lwe.cur");
-    g_hCursorNWSE = LoadDynamicCursor("%SystemRoot%\\Cursors\\lnwse.cur");
-    g_hCursorNESW = LoadDynamicCursor("%SystemRoot%\\Cursors\\lnesw.cur");
-    if (!g_hCursorNS) g_hCursorNS = LoadCursor(NULL, IDC_SIZENS);
-    if (!g_hCursorWE) g_hCursorWE = LoadCursor(NULL, IDC_SIZEWE);
-    if (!g_hCursorNWSE) g_hCursorNWSE = LoadCursor(NULL, IDC_SIZENWSE);
-    if (!g_hCursorNESW) g_hCursorNESW = LoadCursor(NULL, IDC_SIZENESW);
+    for (int i = 0; i < ASSET_CURSOR_COUNT; i++)
+    {
+        *slots[i] = SharedCursor(i);
+        if (!*slots[i]) *slots[i] = LoadDynamicCursor(g_cursorFiles[i]);
+        g_cursorOwned[i] = *slots[i] != NULL;
+        if (!*slots[i]) *slots[i] = LoadCursor(NULL, g_cursorStock[i]);
+    }
+    g_cursorsLoaded = TRUE;
+}
+
+// The system cursor shows a copy, so these can go while it is visible
+void FreeCursors()
+{
+    if (!g_cursorsLoaded) return;
+    HCURSOR* slots[ASSET_CURSOR_COUNT] = {&g_hCursorNS, &g_hCursorWE,
+                                          &g_hCursorNWSE, &g_hCursorNESW};
+    for (int i = 0; i < ASSET_CURSOR_COUNT; i++)
+    {
+        if (g_cursorOwned[i]) DestroyCursor(*slots[i]);
+        *slots[i] = NULL;
+        g_cursorOwned[i] = false;
+    }
+    g_cursorsLoaded = FALSE;
 }
 
 void SetScrollCursor(ScrollCursorType t)
 {
     if (t == g_currentCursorType) return;
+    unsigned long long begin = FlightNow();
     HCURSOR target = g_hCursorAll;
     switch (t)
     {
@@ -1167,13 +2030,268 @@ void SetScrollCursor(ScrollCursorType t)
     }
     SetSystemCursor(CopyCursor(target), OCR_NORMAL);
     g_currentCursorType = t;
+    FlightSpan(FLIGHT_CURSOR, t, begin);
 }
 
 void RestoreSystemCursors()
 {
     if (g_currentCursorType != CURSOR_NONE)
     {
+        unsigned long long begin = FlightNow();
         g_currentCursorType = CURSOR_NONE;
         SystemParametersInfo(SPI_SETCURSORS, 0, NULL, SPIF_SENDCHANGE);
+        FlightSpan(FLIGHT_CURSOR, CURSOR_NONE, begin);
+    }
+}
+
+// --- Shared Asset Pack ---
+// Maps the pack for the current config.ini from the shared_assets
+// directory. The shared name is only built by an administrator or SYSTEM,
+// whose pack every session trusts; other users build one under their own
+// name for their own sessions. Without a pack (or write access to build
+// one) the session draws its own.
+void OpenAssetPack()
+{
+    if (!g_config.shared_assets[0])
+    {
+        g_assets = NULL;
+        return;
+    }
+    unsigned long long source = HashFile("config.ini");
+    const AssetHeader* current = g_assets;
+    if (current && current->source == source) return;
+
+    char name[64], path[MAX_PATH];
+    AssetPackName(name, sizeof(name), source);
+    snprintf(path, sizeof(path), "%s\\%s", g_config.shared_assets, name);
+    const AssetHeader* pack = MapAssetPack(path, source);
+    // Also replaces a pack another user planted under the shared name
+    if (!pack && PublishesSharedAssets() && BuildAssetPack(path, source))
+        pack = MapAssetPack(path, source);
+    char user[257]; // UNLEN + 1
+    DWORD length = sizeof(user);
+    if (!pack && GetUserName(user, &length))
+    {
+        snprintf(path, sizeof(path), "%s\\%s-%s", g_config.shared_assets,
+                 user, name);
+        pack = MapAssetPack(path, source);
+        if (!pack && BuildAssetPack(path, source))
+            pack = MapAssetPack(path, source);
+    }
+    g_assets = pack;
+}
+
+const AssetHeader* MapAssetPack(const char* path, unsigned long long source)
+{
+    HANDLE file = CreateFile(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                             OPEN_EXISTING, 0, NULL);
+    if (file == INVALID_HANDLE_VALUE) return NULL;
+    if (!TrustedAssetOwner(file))
+    {
+        CloseHandle(file);
+        return NULL;
+    }
+    LARGE_INTEGER size;
+    HANDLE mapping = GetFileSizeEx(file, &size) && size.QuadPart > 0
+                         ? CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0,
+                                             NULL)
+                         : NULL;
+    CloseHandle(file);
+    const void* view =
+        mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (mapping) CloseHandle(mapping); // the view keeps it alive
+    const AssetHeader* pack =
+        view ? CheckAssetPack(view, (size_t)size.QuadPart, source) : NULL;
+    if (view && !pack) UnmapViewOfFile(view);
+    return pack;
+}
+
+// Every session maps the pack, so one planted by another user could feed
+// them all crafted bitmaps and cursors. Only packs owned by Administrators,
+// SYSTEM or this user are used; the check runs on the handle that is
+// mapped, so the file cannot be swapped in between.
+bool TrustedAssetOwner(HANDLE file)
+{
+    PSID owner = NULL;
+    PSECURITY_DESCRIPTOR sd = NULL;
+    if (GetSecurityInfo(file, SE_FILE_OBJECT, OWNER_SECURITY_INFORMATION,
+                        &owner, NULL, NULL, NULL, &sd) != ERROR_SUCCESS)
+        return false;
+    bool trusted = IsWellKnownSid(owner, WinBuiltinAdministratorsSid) ||
+                   IsWellKnownSid(owner, WinLocalSystemSid);
+    HANDLE token;
+    if (!trusted && OpenProcessToken(GetCurrentProcess(), TOKEN_QUERY, &token))
+    {
+        DWORD buffer[64]; // TOKEN_USER and the SID it points to
+        DWORD size = 0;
+        if (GetTokenInformation(token, TokenUser, buffer, sizeof(buffer),
+                                &size))
+            trusted = EqualSid(owner, ((TOKEN_USER*)buffer)->User.Sid) != 0;
+        CloseHandle(token);
     }
+    LocalFree(sd);
+    return trusted;
+}
+
+// True when this process runs elevated as an administrator or as SYSTEM:
+// the packs it builds are owned by an account TrustedAssetOwner accepts
+// in every session
+bool PublishesSharedAssets()
+{
+    static const WELL_KNOWN_SID_TYPE accounts[] = {WinBuiltinAdministratorsSid,
+                                                   WinLocalSystemSid};
+    for (int i = 0; i < 2; i++)
+    {
+        BYTE sid[SECURITY_MAX_SID_SIZE];
+        DWORD size = sizeof(sid);
+        BOOL member = FALSE;
+        if (CreateWellKnownSid(accounts[i], NULL, sid, &size) &&
+            CheckTokenMembership(NULL, sid, &member) && member)
+            return true;
+    }
+    return false;
+}
+
+// Appends size bytes at the next ASSET_ALIGN boundary; returns the offset
+static unsigned int AppendAsset(BYTE** data, unsigned int* used,
+                                const void* bytes, unsigned int size)
+{
+    unsigned int offset = (*used + ASSET_ALIGN - 1) & ~(ASSET_ALIGN - 1);
+    *data = (BYTE*)realloc(*data, offset + size);
+    memset(*data + *used, 0, offset - *used);
+    if (bytes) memcpy(*data + offset, bytes, size);
+    *used = offset + size;
+    return offset;
+}
+
+// Appends the first image of a .cur file as icon resource data: the
+// hotspot as two WORDs, then the image. e stays empty if it is unusable.
+static void ReadCursorResource(const char* file, BYTE** data,
+                               unsigned int* used, AssetEntry* e)
+{
+    char path[MAX_PATH];
+    ExpandEnvironmentStrings(file, path, MAX_PATH);
+    FILE* f = fopen(path, "rb");
+    if (!f) return;
+    fseek(f, 0, SEEK_END);
+    long n = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    BYTE* cur = n > 0 ? (BYTE*)malloc(n) : NULL;
+    if (cur && fread(cur, 1, n, f) != (size_t)n) n = 0;
+    fclose(f);
+    // ICONDIR (reserved, type 2, count), then the first ICONDIRENTRY
+    if (cur && n >= 22 && *(WORD*)(cur + 2) == 2 && *(WORD*)(cur + 4) > 0)
+    {
+        DWORD bytes = *(DWORD*)(cur + 14), offset = *(DWORD*)(cur + 18);
+        if (offset <= (DWORD)n && bytes <= (DWORD)n - offset)
+        {
+            e->size = 4 + bytes;
+            e->offset = AppendAsset(data, used, NULL, e->size);
+            memcpy(*data + e->offset, cur + 10, 4);
+            memcpy(*data + e->offset + 4, cur + offset, bytes);
+        }
+    }
+    free(cur);
+}
+
+// Renders everything into a temporary file and publishes it under its
+// final name, replacing whatever is there: callers only build when that
+// is missing, unusable or not to be trusted. Concurrent builders write
+// identical packs, and one that is mapped already stays.
+bool BuildAssetPack(const char* path, unsigned long long source)
+{
+    // Sessions without write access skip GDI+ and draw on their own
+    char temp[MAX_PATH];
+    snprintf(temp, sizeof(temp), "%s.%lu.tmp", path,
+             (unsigned long)GetCurrentProcessId());
+    FILE* file = fopen(temp, "wb");
+    if (!file) return false;
+
+    BYTE* data = NULL;
+    unsigned int used = 0;
+    AssetHeader h;
+    memset(&h, 0, sizeof(h));
+    h.magic = ASSET_MAGIC;
+    h.version = ASSET_VERSION;
+    h.source = source;
+    AppendAsset(&data, &used, NULL, sizeof(AssetHeader));
+
+    // Common scaling steps, then whatever this session's monitors use
+    int dpis[ASSET_MAX_INDICATORS + MAX_MONITORS] = {96, 120, 144, 168, 192};
+    int dpiCount = 5;
+    for (int i = 0; i < g_monitorCount; i++)
+    {
+        int dpi = g_monitors[i].motion.dpi, j = 0;
+        while (j < dpiCount && dpis[j] != dpi) j++;
+        if (j == dpiCount) dpis[dpiCount++] = dpi;
+    }
+
+    EnsureGdiplus();
+    for (int i = 0; i < dpiCount && h.indicator_count < ASSET_MAX_INDICATORS;
+         i++)
+    {
+        float scale = dpis[i] / 96.0f;
+        int w = IndicatorExtent(scale);
+        Bitmap bmp(w, w, PixelFormat32bppPARGB);
+        {
+            Graphics g(&bmp);
+            DrawIndicator(&g, scale);
+        }
+        Rect rect(0, 0, w, w);
+        BitmapData bits;
+        if (bmp.LockBits(&rect, ImageLockModeRead, PixelFormat32bppPARGB,
+                         &bits) != Ok)
+            continue;
+        AssetEntry* e = &h.indicators[h.indicator_count++];
+        e->size = (unsigned int)w * w * 4;
+        e->offset = AppendAsset(&data, &used, NULL, e->size);
+        e->width = e->height = w;
+        e->dpi = dpis[i];
+        for (int y = 0; y < w; y++)
+            memcpy(data + e->offset + y * w * 4,
+                   (BYTE*)bits.Scan0 + y * bits.Stride, w * 4);
+        bmp.UnlockBits(&bits);
+    }
+
+    for (int i = 0; i < ASSET_CURSOR_COUNT; i++)
+        ReadCursorResource(g_cursorFiles[i], &data, &used, &h.cursors[i]);
+
+    h.size = used;
+    memcpy(data, &h, sizeof(h));
+    bool written = fwrite(data, used, 1, file) == 1;
+    if (fclose(file) != 0) written = false;
+    free(data);
+    if (!written || !MoveFileEx(temp, path, MOVEFILE_REPLACE_EXISTING))
+        DeleteFile(temp);
+    return GetFileAttributes(path) != INVALID_FILE_ATTRIBUTES;
+}
+
+// A DIB holding the pack's indicator for dpi, or NULL if it has none
+HBITMAP SharedIndicatorBitmap(int dpi, int size)
+{
+    const AssetHeader* pack = g_assets;
+    const AssetEntry* e = FindIndicator(pack, dpi);
+    if (!e || e->width != size || e->height != size) return NULL;
+    BITMAPINFO bmi = {0};
+    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth = e->width;
+    bmi.bmiHeader.biHeight = -e->height; // top-down, like the pack
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+    void* bits = NULL;
+    HBITMAP hBitmap =
+        CreateDIBSection(NULL, &bmi, DIB_RGB_COLORS, &bits, NULL, 0);
+    if (hBitmap) memcpy(bits, (const BYTE*)pack + e->offset, e->size);
+    return hBitmap;
+}
+
+HCURSOR SharedCursor(int index)
+{
+    const AssetHeader* pack = g_assets;
+    if (!pack || !pack->cursors[index].size) return NULL;
+    const AssetEntry* e = &pack->cursors[index];
+    return (HCURSOR)CreateIconFromResourceEx((PBYTE)pack + e->offset, e->size,
+                                             FALSE, 0x00030000, 0, 0,
+                                             LR_DEFAULTCOLOR);
 }
\ No newline at end of file
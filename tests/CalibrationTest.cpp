@@ -0,0 +1,208 @@
+// Target calibration against mock targets: each one scrolls its content by
+// its own pixels per wheel unit and reports a scroll bar the way
+// TakeScrollSnapshot reads it. Covers MeasureThroughput, RecordCalibration,
+// CalibratedGain and the calibration.ini round trip.
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ScrollEngine.h"
+
+int g_failures = 0;
+
+#define CHECK(cond)                                                            \
+    do                                                                         \
+    {                                                                          \
+        if (!(cond))                                                           \
+        {                                                                      \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__,   \
+                    #cond);                                                    \
+            g_failures++;                                                      \
+        }                                                                      \
+    } while (0)
+
+// --- Mock Target ---
+// Content of contentPixels in a viewPixels window; the scroll bar counts
+// in lines of linePixels, like a list view or an editor.
+typedef struct
+{
+    double pixelsPerUnit;
+    int viewPixels, contentPixels, linePixels;
+    double offset; // pixels scrolled from the top
+} MockTarget;
+
+static void MockScroll(MockTarget* t, int units)
+{
+    // Positive wheel units scroll towards the top
+    t->offset -= units * t->pixelsPerUnit;
+    if (t->offset < 0) t->offset = 0;
+    double end = t->contentPixels - t->viewPixels;
+    if (t->offset > end) t->offset = end;
+}
+
+static void MockSnapshot(const MockTarget* t, ScrollSnapshot* s)
+{
+    s->min = 0;
+    s->max = t->contentPixels / t->linePixels - 1;
+    s->page = t->viewPixels / t->linePixels;
+    s->pos = (int)(t->offset / t->linePixels);
+    s->view_pixels = t->viewPixels;
+}
+
+// One gesture's burst in wheel-sized steps; returns the measurement
+static float MeasureBurst(MockTarget* t, int units, int step)
+{
+    ScrollSnapshot before, after;
+    MockSnapshot(t, &before);
+    for (int sent = 0; abs(sent) < abs(units); sent += step)
+        MockScroll(t, step);
+    MockSnapshot(t, &after);
+    return MeasureThroughput(&before, &after, units);
+}
+
+static bool Near(double a, double b, double tolerance)
+{
+    return fabs(a - b) <= tolerance * fabs(b);
+}
+
+// --- MeasureThroughput ---
+void TestMeasure()
+{
+    // Browser-like: 100 pixels per notch, 20-pixel scroll bar lines.
+    // Starting mid-line keeps the bar's rounding out of the result.
+    MockTarget browser = {100.0 / 120.0, 800, 40000, 20, 20010};
+    float ppu = MeasureBurst(&browser, -1200, -40);
+    CHECK(Near(ppu, 100.0 / 120.0, 0.02));
+
+    // Explorer-like: three 16-pixel lines per notch
+    MockTarget list = {48.0 / 120.0, 640, 32000, 16, 16008};
+    ppu = MeasureBurst(&list, 2400, 120);
+    CHECK(Near(ppu, 48.0 / 120.0, 0.02));
+
+    // Bursts that cannot tell
+    MockTarget t = browser;
+    CHECK(MeasureBurst(&t, CALIBRATION_MIN_UNITS - 1, 1) == 0.0f);
+    t.offset = 200; // runs into the top
+    CHECK(MeasureBurst(&t, 1200, 40) == 0.0f);
+    t.offset = 20010;
+    t.pixelsPerUnit = -t.pixelsPerUnit; // moved the wrong way
+    CHECK(MeasureBurst(&t, 1200, 40) == 0.0f);
+
+    ScrollSnapshot before, after;
+    MockSnapshot(&browser, &before);
+    MockScroll(&browser, 1200);
+    MockSnapshot(&browser, &after);
+    after.page++; // window resized mid-gesture
+    CHECK(MeasureThroughput(&before, &after, 1200) == 0.0f);
+    before.page = 0;
+    CHECK(MeasureThroughput(&before, &after, 1200) == 0.0f);
+}
+
+// --- Calibrated Gain ---
+// After calibration the same burst covers the reference distance in every
+// target, which is the point of the feature
+void TestGainEvensTargets()
+{
+    double ratios[] = {0.25, 0.4, 100.0 / 120.0, 1.5, 3.0};
+    for (int i = 0; i < 5; i++)
+    {
+        MockTarget t = {ratios[i], 800, 400000, 8, 200000};
+        CalibrationCache cache;
+        memset(&cache, 0, sizeof(cache));
+        for (int g = 0; g < CALIBRATION_SAMPLES; g++)
+            RecordCalibration(&cache, "app.exe|View",
+                              MeasureBurst(&t, 1200, 120));
+        float gain = CalibratedGain(FindCalibration(&cache, "app.exe|View"));
+        double before = t.offset;
+        MockScroll(&t, (int)(1200 * gain + 0.5f));
+        CHECK(Near(before - t.offset, 1200 * CALIBRATION_REFERENCE, 0.03));
+    }
+
+    CHECK(CalibratedGain(NULL) == 1.0f);
+    Calibration tiny = {"x", 0.001f, 1}, huge = {"y", 1000.0f, 1};
+    CHECK(CalibratedGain(&tiny) == 10.0f);
+    CHECK(CalibratedGain(&huge) == 0.1f);
+}
+
+// --- RecordCalibration ---
+void TestRecord()
+{
+    CalibrationCache c;
+    memset(&c, 0, sizeof(c));
+    RecordCalibration(&c, "a.exe|A", 1.0f);
+    RecordCalibration(&c, "a.exe|A", 2.0f);
+    const Calibration* a = FindCalibration(&c, "a.exe|A");
+    CHECK(a && a->samples == 2 && Near(a->pixels_per_unit, 1.5, 1e-6));
+
+    // Samples stop counting at CALIBRATION_SAMPLES; later ones still move
+    // the average, as one of CALIBRATION_SAMPLES
+    for (int i = 0; i < 40; i++) RecordCalibration(&c, "a.exe|A", 1.0f);
+    CHECK(a->samples == CALIBRATION_SAMPLES);
+    CHECK(Near(a->pixels_per_unit, 1.0, 0.01));
+    RecordCalibration(&c, "a.exe|A", 2.0f);
+    CHECK(Near(a->pixels_per_unit, 1.0 + 1.0 / CALIBRATION_SAMPLES, 0.01));
+
+    // A full cache gives up the target with the fewest samples
+    char key[32];
+    for (int i = 1; i < MAX_CALIBRATIONS; i++)
+    {
+        snprintf(key, sizeof(key), "t%d.exe|C", i);
+        RecordCalibration(&c, key, 1.0f);
+        if (i != 7) RecordCalibration(&c, key, 1.0f);
+    }
+    CHECK(c.count == MAX_CALIBRATIONS);
+    RecordCalibration(&c, "new.exe|N", 0.5f);
+    CHECK(c.count == MAX_CALIBRATIONS);
+    CHECK(FindCalibration(&c, "t7.exe|C") == NULL);
+    CHECK(FindCalibration(&c, "new.exe|N") != NULL);
+    CHECK(FindCalibration(&c, "a.exe|A") != NULL);
+}
+
+// --- calibration.ini ---
+void TestFileRoundTrip()
+{
+    const char* path = "calibrationtest.ini";
+    CalibrationCache c, back;
+    memset(&c, 0, sizeof(c));
+    RecordCalibration(&c, "chrome.exe|Chrome_RenderWidgetHostHWND", 0.8333f);
+    RecordCalibration(&c, "My App.exe|Afx:0040=1", 0.4f); // spaces and '='
+    RecordCalibration(&c, "My App.exe|Afx:0040=1", 0.4f);
+    CHECK(WriteCalibrationFile(path, &c));
+    CHECK(ReadCalibrationFile(path, &back));
+    CHECK(back.count == 2);
+    for (int i = 0; i < c.count; i++)
+    {
+        const Calibration* r = FindCalibration(&back, c.entries[i].key);
+        CHECK(r != NULL);
+        if (!r) continue;
+        CHECK(r->samples == c.entries[i].samples);
+        CHECK(Near(r->pixels_per_unit, c.entries[i].pixels_per_unit, 1e-3));
+    }
+
+    // Hand-edited files: junk lines are skipped, not fatal
+    FILE* f = fopen(path, "w");
+    fprintf(f, "[Calibration]\n# comment\nbad line\nzero.exe|Z=0 3\n"
+               "=1.0 2\nok.exe|O=0.5 4\n");
+    fclose(f);
+    CHECK(ReadCalibrationFile(path, &back));
+    CHECK(back.count == 1 && FindCalibration(&back, "ok.exe|O") != NULL);
+    remove(path);
+    CHECK(!ReadCalibrationFile(path, &back) && back.count == 0);
+}
+
+// --- Entry Point ---
+int main()
+{
+    TestMeasure();
+    TestGainEvensTargets();
+    TestRecord();
+    TestFileRoundTrip();
+    if (g_failures)
+    {
+        fprintf(stderr, "%d checks failed\n", g_failures);
+        return 1;
+    }
+    printf("calibration tests passed\n");
+    return 0;
+}
@@ -0,0 +1,121 @@
+// Flight recorder: thread names in the exported trace must stay with the
+// threads that wrote the records, however many threads have come and gone
+// (a few per gesture). Exits non-zero if any check fails.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <thread>
+
+#include "ScrollEngine.h"
+
+int g_failures = 0;
+
+#define CHECK(cond)                                                            \
+    do                                                                         \
+    {                                                                          \
+        if (!(cond))                                                           \
+        {                                                                      \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__,   \
+                    #cond);                                                    \
+            g_failures++;                                                      \
+        }                                                                      \
+    } while (0)
+
+// A short-lived worker, like a gesture's sampler: one record whose arg is
+// the number in its name
+void Worker(int n)
+{
+    char name[16];
+    snprintf(name, sizeof(name), "worker%d", n);
+    FlightNameThread(name);
+    FlightSpan(FLIGHT_SAMPLER_TICK, n, FlightNow());
+    FlightReleaseThread();
+}
+
+// --- Thread Names ---
+// Reads the dump back line by line: one record or thread name per line
+void TestNamesSurviveReuse()
+{
+    FlightNameThread("main");
+    FlightSpan(FLIGHT_HOOK_MOUSE, -1, FlightNow());
+    const int workers = 1000; // several wraps of any 8-bit id
+    for (int n = 0; n < workers; n++)
+    {
+        std::thread t(Worker, n);
+        t.join();
+    }
+
+    const char* path = "flighttest.json";
+    CHECK(DumpFlightTrace(path));
+    FILE* f = fopen(path, "r");
+    CHECK(f != NULL);
+    if (!f) return;
+
+    static char names[8 * 256][16];
+    static int args[8 * 256 * 16];
+    static int tids[8 * 256 * 16];
+    int records = 0, named = 0;
+    char line[512];
+    while (fgets(line, sizeof(line), f))
+    {
+        int tid, arg;
+        char name[16];
+        const char* x = strstr(line, "\"ph\":\"X\"");
+        const char* m = strstr(line, "\"thread_name\"");
+        if (x && sscanf(strstr(line, "\"tid\":"), "\"tid\":%d", &tid) == 1 &&
+            sscanf(strstr(line, "\"arg\":"), "\"arg\":%d", &arg) == 1)
+        {
+            CHECK(tid >= 0 && tid < 8 * 256);
+            if (records < 8 * 256 * 16)
+            {
+                tids[records] = tid;
+                args[records++] = arg;
+            }
+        }
+        else if (m &&
+                 sscanf(strstr(line, "\"tid\":"), "\"tid\":%d", &tid) == 1 &&
+                 sscanf(strstr(line, "\"args\":{\"name\":\"") + 16,
+                        "%15[^\"]", name) == 1)
+        {
+            CHECK(tid >= 0 && tid < 8 * 256);
+            if (tid >= 0 && tid < 8 * 256)
+            {
+                CHECK(names[tid][0] == 0); // one name per tid
+                strcpy(names[tid], name);
+                named++;
+            }
+        }
+    }
+    fclose(f);
+    remove(path);
+
+    // Every record is labelled with the name of the thread that wrote it
+    int recent = 0;
+    for (int i = 0; i < records; i++)
+    {
+        char expected[32];
+        if (args[i] < 0)
+            strcpy(expected, "main");
+        else
+            snprintf(expected, sizeof(expected), "worker%d", args[i]);
+        CHECK(strcmp(names[tids[i]], expected) == 0);
+        if (args[i] >= workers - 4) recent++;
+    }
+    // Finished threads' rings are kept, so the last workers are all there
+    CHECK(records > 4 && named > 4);
+    CHECK(recent == 4);
+}
+
+// --- Entry Point ---
+int main()
+{
+    TestNamesSurviveReuse();
+    if (g_failures)
+    {
+        fprintf(stderr, "%d checks failed\n", g_failures);
+        return 1;
+    }
+    printf("flight recorder tests passed\n");
+    return 0;
+}
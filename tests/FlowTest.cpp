@@ -0,0 +1,271 @@
+// Wheel flow control against simulated slow targets on a virtual clock:
+// a window that handles one message per service time, fed a steady
+// diagonal scroll the way the Win32 EmitScroll feeds it. Prints queue
+// depth, lag behind the gesture and how long content keeps moving after
+// release, with and without flow control, and checks the bounds.
+#include <stdio.h>
+#include <string.h>
+
+#include "ScrollEngine.h"
+
+int g_failures = 0;
+
+#define CHECK(cond)                                                            \
+    do                                                                         \
+    {                                                                          \
+        if (!(cond))                                                           \
+        {                                                                      \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__,   \
+                    #cond);                                                    \
+            g_failures++;                                                      \
+        }                                                                      \
+    } while (0)
+
+#define TARGET_QUEUE_SIZE 8192
+#define TICK_V 120 // one notch per tick, plus some sideways drift
+#define TICK_H 40
+
+// --- Slow Target ---
+typedef struct
+{
+    int delta, horizontal, ack;
+    double sent;
+} QueuedMessage;
+
+typedef struct
+{
+    double service; // seconds spent on each message
+    QueuedMessage queue[TARGET_QUEUE_SIZE];
+    int head, tail;
+    double busyUntil;
+    long long appliedV, appliedH;
+    // Handled messages whose acknowledgement waits for the sender to pump
+    double acks[TARGET_QUEUE_SIZE];
+    int ackCount;
+} SlowTarget;
+
+static int Queued(const SlowTarget* t)
+{
+    return t->tail - t->head;
+}
+
+// Handles every message it gets through by now, one after the other
+static void RunTarget(SlowTarget* t, double now)
+{
+    while (Queued(t) > 0)
+    {
+        QueuedMessage* m = &t->queue[t->head % TARGET_QUEUE_SIZE];
+        double start = t->busyUntil > m->sent ? t->busyUntil : m->sent;
+        if (start + t->service > now) break;
+        t->busyUntil = start + t->service;
+        if (m->horizontal)
+            t->appliedH += m->delta;
+        else
+            t->appliedV += m->delta;
+        if (m->ack) t->acks[t->ackCount++] = m->sent;
+        t->head++;
+    }
+}
+
+// --- Simulation ---
+typedef struct
+{
+    int maxQueue, steadyQueue; // deepest queue overall and in the 2nd half
+    double maxLag, steadyLag;  // seconds of scrolling not shown yet
+    double settle;             // content still moving after release
+    bool conserved;            // nothing lost while scrolling
+    int overdue;               // ticks that would check for a hang
+} FlowResult;
+
+static void Simulate(double service, int maxPending, double seconds,
+                     FlowResult* r)
+{
+    static SlowTarget t;
+    memset(&t, 0, sizeof(t));
+    memset(r, 0, sizeof(*r));
+    t.service = service;
+    WheelFlow f = {0};
+    ResetWheelFlow(&f);
+
+    double dt = 1.0 / SampleFrequency();
+    int ticks = (int)(seconds / dt);
+    long long producedV = 0, producedH = 0;
+    double now = 0.0;
+    for (int i = 0; i < ticks; i++)
+    {
+        now = i * dt;
+        RunTarget(&t, now);
+        // As on Win32: acknowledgements are collected by the pumping wait
+        // before the tick
+        for (int a = 0; a < t.ackCount; a++)
+            AckWheelMessage(&f, now - t.acks[a], now);
+        t.ackCount = 0;
+        if (maxPending > 0 && WheelAckOverdue(&f, now)) r->overdue++;
+
+        f.pendingV += TICK_V;
+        f.pendingH += TICK_H;
+        producedV += TICK_V;
+        producedH += TICK_H;
+        WheelMessage messages[WHEEL_TICK_MESSAGES];
+        int count = PlanWheelMessages(&f, maxPending, now, messages);
+        for (int m = 0; m < count && Queued(&t) < TARGET_QUEUE_SIZE; m++)
+        {
+            QueuedMessage q = {messages[m].delta, messages[m].horizontal,
+                               messages[m].ack, now};
+            t.queue[t.tail++ % TARGET_QUEUE_SIZE] = q;
+        }
+
+        if (Queued(&t) > r->maxQueue) r->maxQueue = Queued(&t);
+        if (i >= ticks / 2 && Queued(&t) > r->steadyQueue)
+            r->steadyQueue = Queued(&t);
+        double lag = (double)(producedV - t.appliedV) / (TICK_V / dt);
+        if (lag > r->maxLag) r->maxLag = lag;
+        if (i >= ticks / 2 && lag > r->steadyLag) r->steadyLag = lag;
+    }
+
+    long long queuedV = 0, queuedH = 0;
+    for (int q = t.head; q != t.tail; q++)
+    {
+        const QueuedMessage* m = &t.queue[q % TARGET_QUEUE_SIZE];
+        if (m->horizontal)
+            queuedH += m->delta;
+        else
+            queuedV += m->delta;
+    }
+    r->conserved = t.appliedV + queuedV + f.pendingV == producedV &&
+                   t.appliedH + queuedH + f.pendingH == producedH;
+
+    // Release: held-back deltas are dropped, the queue drains
+    ResetWheelFlow(&f);
+    double released = now;
+    while (Queued(&t) > 0)
+    {
+        now += dt;
+        RunTarget(&t, now);
+    }
+    r->settle = t.busyUntil > released ? t.busyUntil - released : 0.0;
+}
+
+// --- Slow Consumers ---
+void TestSlowConsumers()
+{
+    g_config.update_frequency = 60;
+    g_config.output_frequency = 0;
+    const double services[] = {0.002, 0.025, 0.1}; // fast, busy, choking
+    printf("%-10s %-5s %9s %12s %10s %13s %9s\n", "service", "flow",
+           "max_queue", "steady_queue", "max_lag_ms", "steady_lag_ms",
+           "settle_ms");
+    for (int s = 0; s < 3; s++)
+    {
+        FlowResult off, on;
+        Simulate(services[s], 0, 10.0, &off);
+        Simulate(services[s], 3, 10.0, &on);
+        const FlowResult* results[2] = {&off, &on};
+        for (int i = 0; i < 2; i++)
+            printf("%7.0f ms %-5s %9d %12d %10.1f %13.1f %9.1f\n",
+                   services[s] * 1000, i ? "on" : "off", results[i]->maxQueue,
+                   results[i]->steadyQueue, results[i]->maxLag * 1000,
+                   results[i]->steadyLag * 1000, results[i]->settle * 1000);
+        CHECK(off.conserved && on.conserved);
+
+        if (s == 0)
+        {
+            // A target that keeps up sees no difference, and is never
+            // asked whether it hangs
+            CHECK(on.maxQueue <= WHEEL_TICK_MESSAGES);
+            CHECK(on.overdue == 0);
+            CHECK(on.maxLag <= off.maxLag + 1e-9);
+            CHECK(on.settle < 1.0 / 60);
+            continue;
+        }
+        // Without flow control the backlog grows for as long as the
+        // gesture lasts and the content runs on long after release
+        CHECK(off.steadyQueue > 100);
+        CHECK(off.settle > 1.0);
+        // With it the queue stays bounded. Once the round trip shows the
+        // target is slow, one acknowledged message is kept in flight, plus
+        // at most the unacknowledged other axis of it and of the tick
+        // before
+        int inFlight = 2 * WHEEL_TICK_MESSAGES - 1;
+        CHECK(on.maxQueue <= 3 * WHEEL_TICK_MESSAGES);
+        CHECK(on.steadyQueue <= inFlight);
+        CHECK(on.settle <= inFlight * services[s] + 1e-9);
+        CHECK(on.steadyLag <= (inFlight + 1) * services[s] + 1.0 / 60);
+    }
+}
+
+// --- Planner ---
+void TestPlan()
+{
+    g_config.update_frequency = 60;
+    g_config.output_frequency = 0;
+    WheelFlow f = {0};
+    WheelMessage m[WHEEL_TICK_MESSAGES];
+
+    // One acknowledged message per tick, on the vertical axis if any
+    f.pendingV = 240;
+    f.pendingH = -40;
+    CHECK(PlanWheelMessages(&f, 3, 0.0, m) == 2);
+    CHECK(m[0].horizontal == 0 && m[0].delta == 240 && m[0].ack);
+    CHECK(m[1].horizontal == 1 && m[1].delta == -40 && !m[1].ack);
+    CHECK(f.outstanding == 1 && f.pendingV == 0 && f.pendingH == 0);
+    f.pendingH = 10;
+    CHECK(PlanWheelMessages(&f, 3, 0.0, m) == 1 && m[0].ack);
+
+    // Deltas past a message's range wait for the next one
+    f.pendingV = 40000;
+    CHECK(PlanWheelMessages(&f, 3, 0.0, m) == 1 && m[0].delta == 32767);
+    CHECK(f.outstanding == 3 && f.pendingV == 40000 - 32767);
+    CHECK(PlanWheelMessages(&f, 3, 0.0, m) == 0); // limit reached: merge
+
+    // Overdue once nothing came back for the round trip and
+    // WHEEL_OVERDUE_TICKS more, counted from the last acknowledgement
+    CHECK(!WheelAckOverdue(&f, (WHEEL_OVERDUE_TICKS - 0.5) / 60));
+    CHECK(WheelAckOverdue(&f, (WHEEL_OVERDUE_TICKS + 0.5) / 60));
+    AckWheelMessage(&f, 1.0, 1.0);
+    CHECK(!WheelAckOverdue(&f, 1.5));
+    CHECK(WheelAckOverdue(&f, 2.0 + (WHEEL_OVERDUE_TICKS + 0.5) / 60));
+
+    // A fast round trip allows the full depth, a slow one only one
+    ResetWheelFlow(&f);
+    AckWheelMessage(&f, 0.5 / 60, 0.0);
+    f.pendingV = 120;
+    CHECK(PlanWheelMessages(&f, 3, 0.0, m) == 1);
+    f.pendingV = 120;
+    CHECK(PlanWheelMessages(&f, 3, 0.0, m) == 1);
+    ResetWheelFlow(&f);
+    CHECK(f.rtt == 0.0);
+    f.outstanding = 1;
+    AckWheelMessage(&f, 3.0 / 60, 0.0);
+    CHECK(f.outstanding == 0);
+    f.pendingV = 120;
+    CHECK(PlanWheelMessages(&f, 3, 0.0, m) == 1);
+    f.pendingV = 120;
+    CHECK(PlanWheelMessages(&f, 3, 0.0, m) == 0);
+    AckWheelMessage(&f, -1.0, 0.0); // lost: frees the slot, keeps the rtt
+    CHECK(f.outstanding == 0 && f.rtt == 3.0 / 60);
+
+    // Without flow control everything goes out unacknowledged
+    ResetWheelFlow(&f);
+    for (int i = 0; i < 10; i++)
+    {
+        f.pendingV = 120;
+        CHECK(PlanWheelMessages(&f, 0, 0.0, m) == 1 && !m[0].ack);
+    }
+    CHECK(f.outstanding == 0);
+}
+
+// --- Entry Point ---
+int main()
+{
+    g_config.trace_file[0] = 0;
+    TestPlan();
+    TestSlowConsumers();
+    if (g_failures)
+    {
+        fprintf(stderr, "%d checks failed\n", g_failures);
+        return 1;
+    }
+    printf("flow control tests passed\n");
+    return 0;
+}
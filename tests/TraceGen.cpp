@@ -0,0 +1,184 @@
+// Records synthetic gestures as a trace_file, on a virtual clock, for
+// ScrollReplay checks that need no recorded input: three sweeping
+// gestures that scroll on both axes at once, or with --cruise one
+// ten-minute cruise on a clock that wakes up late the way Sleep does.
+//   tracegen out.bin [--filter] [--decoupled] [--cruise]
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ScrollEngine.h"
+
+// --- Virtual Backend ---
+double g_now = 1000.0;
+int g_pointerX = 0, g_pointerY = 0;
+
+void GenGetPointer(int* x, int* y)
+{
+    *x = g_pointerX;
+    *y = g_pointerY;
+}
+
+void GenEmitScroll(int vS, int hS)
+{
+}
+
+void GenSetFeedback(ScrollCursorType t)
+{
+}
+
+double GenNow()
+{
+    return g_now;
+}
+
+void GenWait(int ms)
+{
+}
+
+const ScrollBackend g_genBackend = {GenGetPointer, GenEmitScroll,
+                                    GenSetFeedback, GenNow,
+                                    GenWait,        GenWait,
+                                    GenWait};
+
+// --- Gestures ---
+void StartGesture(int dpi)
+{
+    g_pointerX = g_pointerY = 0;
+    OnTriggerButtonDown(0, 0, 0);
+    OnPrimedMove(30, 40);
+    BeginScrolling(0, 0);
+    MotionProfile m;
+    ScaleMotionProfile(&m, dpi);
+    SelectMotionProfile(&m);
+}
+
+void FinishGesture()
+{
+    OnTriggerButtonUp(0);
+    EndScrolling();
+    g_scrollState = STATE_IDLE;
+    g_now += 1.0;
+}
+
+void RecordSweeps(bool decoupled)
+{
+    for (int gesture = 0; gesture < 3; gesture++)
+    {
+        StartGesture(gesture == 1 ? 144 : 96);
+        SamplerState sampler;
+        BeginSampler(&sampler, decoupled);
+        EmitterState emitter;
+        memset(&emitter, 0, sizeof(emitter));
+        emitter.last = -1.0;
+        PublishVelocity(0.0f, 0.0f);
+        for (int i = 0; i < 600; i++)
+        {
+            // A slow sweep around the anchor plus hand tremor
+            g_pointerX = (int)(120 * sin(i * 0.011)) + (i % 3);
+            g_pointerY = (int)(300 * cos(i * 0.013)) - (i % 2);
+            g_now += 1.0 / 60;
+            SamplerTick(&sampler, &g_genBackend);
+            for (int k = 0; decoupled && k < 4; k++)
+            {
+                g_now += 1.0 / 240;
+                EmitterTick(&emitter, &g_genBackend);
+            }
+        }
+        FinishGesture();
+    }
+}
+
+// Up to ms milliseconds of wake-up delay, the same sequence every run
+double LateBy(double ms)
+{
+    static unsigned int seed = 12345;
+    seed = seed * 1103515245u + 12345u;
+    return (seed >> 16) % 1000 / 1000.0 * ms / 1000.0;
+}
+
+// Locked 5 s in, nudged faster halfway, released after ten minutes; the
+// hand drifts off the locked offset the whole time
+void RecordCruise(bool decoupled)
+{
+    StartGesture(96);
+    SamplerState sampler;
+    BeginSampler(&sampler, decoupled);
+    EmitterState emitter;
+    memset(&emitter, 0, sizeof(emitter));
+    emitter.last = -1.0;
+    PublishVelocity(0.0f, 0.0f);
+
+    double start = g_now;
+    double nextSample = start, nextOutput = start;
+    bool locked = false, nudged = false;
+    while (true)
+    {
+        bool sample = !decoupled || nextSample <= nextOutput;
+        g_now = sample ? nextSample : nextOutput;
+        double t = g_now - start;
+        if (t >= 605.0) break;
+        g_pointerX = 40 + (int)(25 * sin(t * 0.7));
+        g_pointerY = 180 + (int)(60 * sin(t * 0.31));
+        if (!locked && t >= 5.0)
+        {
+            OnCruiseToggle();
+            locked = true;
+        }
+        if (!nudged && t >= 305.0)
+        {
+            OnCruiseNudge(1);
+            nudged = true;
+        }
+        if (sample)
+        {
+            SamplerTick(&sampler, &g_genBackend);
+            nextSample += 1.0 / 60 + LateBy(8.0);
+        }
+        else
+        {
+            EmitterTick(&emitter, &g_genBackend);
+            nextOutput += 1.0 / 240 + LateBy(2.0);
+        }
+    }
+    FinishGesture();
+}
+
+// --- Entry Point ---
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr,
+                "usage: %s out.bin [--filter] [--decoupled] [--cruise]\n",
+                argv[0]);
+        return 1;
+    }
+    g_config.input_filter = FILTER_NONE;
+    g_config.output_frequency = 0;
+    g_config.max_pending_messages = 3;
+    bool cruise = false;
+    for (int i = 2; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--filter"))
+            g_config.input_filter = FILTER_ONE_EURO;
+        else if (!strcmp(argv[i], "--decoupled"))
+            g_config.output_frequency = 240;
+        else if (!strcmp(argv[i], "--cruise"))
+            cruise = true;
+    }
+    CompileTriggerTable(&g_triggers);
+    if (!OpenTrace(argv[1], GenNow))
+    {
+        fprintf(stderr, "cannot write %s\n", argv[1]);
+        return 1;
+    }
+
+    bool decoupled = g_config.output_frequency > 0;
+    if (cruise)
+        RecordCruise(decoupled);
+    else
+        RecordSweeps(decoupled);
+    CloseTrace();
+    return 0;
+}
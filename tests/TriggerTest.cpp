@@ -0,0 +1,259 @@
+// Trigger dispatch table: binding parsing, table compilation, lookup with
+// modifier specificity, and the held-button bookkeeping of the input
+// backends. Runs on any platform; exits non-zero if any check fails.
+#include <stdio.h>
+#include <string.h>
+
+#include "ScrollEngine.h"
+
+int g_failures = 0;
+
+#define CHECK(cond)                                                            \
+    do                                                                         \
+    {                                                                          \
+        if (!(cond))                                                           \
+        {                                                                      \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__,   \
+                    #cond);                                                    \
+            g_failures++;                                                      \
+        }                                                                      \
+    } while (0)
+
+static TriggerBinding Parse(const char* spec)
+{
+    TriggerBinding b;
+    CHECK(ParseTriggerBinding(spec, &b));
+    return b;
+}
+
+// --- ParseTriggerBinding ---
+void TestParse()
+{
+    g_config.trigger_mode = MODE_HOLD;
+    TriggerBinding b = Parse("mbutton");
+    CHECK(b.button == TRIGGER_BUTTON_MIDDLE && b.vk_code == 0);
+    CHECK(b.modifiers == 0 && b.mode == MODE_INHERIT && b.pan == 0);
+    CHECK(b.sensitivity == 0.0f);
+
+    b = Parse("ctrl+shift+x1 toggle 2.5");
+    CHECK(b.button == TRIGGER_BUTTON_X1);
+    CHECK(b.modifiers == (CHORD_CTRL | CHORD_SHIFT));
+    CHECK(b.mode == MODE_TOGGLE && b.sensitivity == 2.5f);
+
+    b = Parse("Control+Alt+Win+xbutton2 hold pan");
+    CHECK(b.button == TRIGGER_BUTTON_X2 && b.pan == 1);
+    CHECK(b.modifiers == (CHORD_CTRL | CHORD_ALT | CHORD_WIN));
+
+    b = Parse("alt+F5");
+    CHECK(b.button == 0 && b.vk_code == 0x74 && b.modifiers == CHORD_ALT);
+    CHECK(Parse("a").vk_code == 'A');
+    CHECK(Parse("7").vk_code == '7');
+    CHECK(Parse("0x91").vk_code == 0x91);
+    CHECK(Parse("lbutton").button == TRIGGER_BUTTON_LEFT);
+    CHECK(Parse("rbutton").button == TRIGGER_BUTTON_RIGHT);
+    CHECK(Parse("middle").button == TRIGGER_BUTTON_MIDDLE);
+
+    g_config.trigger_mode = MODE_TOGGLE;
+    CHECK(Parse("x1").mode == MODE_INHERIT); // resolved when compiled
+    g_config.trigger_mode = MODE_HOLD;
+
+    TriggerBinding bad;
+    CHECK(!ParseTriggerBinding("", &bad));
+    CHECK(!ParseTriggerBinding("ctrl", &bad));
+    CHECK(!ParseTriggerBinding("ctrl+bogus", &bad));
+    CHECK(!ParseTriggerBinding("0x100", &bad));
+}
+
+// --- CompileTriggerTable ---
+static void ConfigureBindings(const char** specs, int count)
+{
+    g_config.trigger_middle_mouse = 0;
+    g_config.trigger_vk_code = 0;
+    g_config.cancel_vk_code = 0;
+    g_config.cruise_vk_code = 0;
+    g_config.cruise_faster_vk_code = 0;
+    g_config.cruise_slower_vk_code = 0;
+    g_config.trigger_count = 0;
+    for (int i = 0; i < count && i < MAX_TRIGGER_BINDINGS; i++)
+    {
+        CHECK(ParseTriggerBinding(specs[i],
+                                  &g_config.triggers[g_config.trigger_count]));
+        g_config.trigger_count++;
+    }
+}
+
+void TestCompile()
+{
+    const char* specs[] = {"x1 toggle", "ctrl+f2"};
+    ConfigureBindings(specs, 2);
+    g_config.trigger_middle_mouse = 1;
+    g_config.trigger_vk_code = 0x14;
+    g_config.cancel_vk_code = 0x1B;
+    g_config.cruise_vk_code = 0x13;
+    TriggerTable t;
+    CompileTriggerTable(&t);
+
+    // Legacy keys first, then the 'trigger =' lines in order
+    CHECK(t.count == 4);
+    CHECK(t.bindings[0].button == TRIGGER_BUTTON_MIDDLE);
+    CHECK(t.bindings[1].vk_code == 0x14);
+    CHECK(t.bindings[2].button == TRIGGER_BUTTON_X1);
+    CHECK(t.bindings[2].mode == MODE_TOGGLE);
+    CHECK(t.bindings[3].vk_code == 0x71);
+    CHECK(t.buttonMask == (TRIGGER_BUTTON_MIDDLE | TRIGGER_BUTTON_X1));
+
+    // Cancel and cruise keys pass the hook's bit test without a binding
+    CHECK(IsTriggerKey(&t, 0x14) && IsTriggerKey(&t, 0x71));
+    CHECK(IsTriggerKey(&t, 0x1B) && IsTriggerKey(&t, 0x13));
+    CHECK(!IsTriggerKey(&t, 'A') && !IsTriggerKey(&t, 0x70));
+    CHECK(!IsTriggerKey(&t, 256) && !IsTriggerKey(&t, 0xFFFFFFFFu));
+
+    // Extra lines past the table size are dropped, not overrun
+    const char* many[MAX_TRIGGER_BINDINGS];
+    for (int i = 0; i < MAX_TRIGGER_BINDINGS; i++) many[i] = "x2";
+    ConfigureBindings(many, MAX_TRIGGER_BINDINGS);
+    g_config.trigger_middle_mouse = 1;
+    CompileTriggerTable(&t);
+    CHECK(t.count == MAX_TRIGGER_BINDINGS);
+    CHECK(t.bindings[0].button == TRIGGER_BUTTON_MIDDLE);
+
+    // Bindings without a mode of their own follow trigger_mode as it is
+    // when the table is compiled, wherever the file sets it
+    const char* modes[] = {"x1", "x2 hold"};
+    ConfigureBindings(modes, 2);
+    g_config.trigger_mode = MODE_TOGGLE;
+    CompileTriggerTable(&t);
+    CHECK(t.bindings[0].mode == MODE_TOGGLE && t.bindings[1].mode == MODE_HOLD);
+    g_config.trigger_mode = MODE_HOLD;
+    CompileTriggerTable(&t);
+    CHECK(t.bindings[0].mode == MODE_HOLD);
+}
+
+// --- LoadConfig ---
+void TestLoadConfig()
+{
+    const char* path = "triggertest.ini";
+    FILE* f = fopen(path, "w");
+    fprintf(f, "trigger = x1\ntrigger = ctrl+f2 hold\ntrigger_mode = toggle\n");
+    fclose(f);
+    LoadConfig(path);
+    CHECK(g_config.trigger_count == 2);
+    CHECK(g_triggers.count == 2 && g_triggers.bindings[0].mode == MODE_TOGGLE);
+    CHECK(g_triggers.bindings[1].mode == MODE_HOLD);
+
+    // A file without trigger lines leaves none from the last load
+    f = fopen(path, "w");
+    fprintf(f, "trigger_mode = hold\n");
+    fclose(f);
+    LoadConfig(path);
+    CHECK(g_config.trigger_count == 0 && g_triggers.count == 0);
+    remove(path);
+}
+
+// --- Lookup & Specificity ---
+void TestFindBinding()
+{
+    // Listed most specific first, so order cannot be what decides
+    const char* specs[] = {"ctrl+shift+rbutton", "ctrl+rbutton", "rbutton",
+                           "shift+f9", "f9", "ctrl+alt+f9"};
+    ConfigureBindings(specs, 6);
+    TriggerTable t;
+    CompileTriggerTable(&t);
+
+    CHECK(FindButtonBinding(&t, TRIGGER_BUTTON_RIGHT, 0) == 2);
+    CHECK(FindButtonBinding(&t, TRIGGER_BUTTON_RIGHT, CHORD_CTRL) == 1);
+    CHECK(FindButtonBinding(&t, TRIGGER_BUTTON_RIGHT,
+                            CHORD_CTRL | CHORD_SHIFT) == 0);
+    CHECK(FindButtonBinding(&t, TRIGGER_BUTTON_RIGHT,
+                            CHORD_CTRL | CHORD_SHIFT | CHORD_ALT) == 0);
+    CHECK(FindButtonBinding(&t, TRIGGER_BUTTON_RIGHT, CHORD_SHIFT) == 2);
+    CHECK(FindButtonBinding(&t, TRIGGER_BUTTON_MIDDLE, 0) == -1);
+
+    CHECK(FindKeyBinding(&t, 0x78, 0) == 4);
+    CHECK(FindKeyBinding(&t, 0x78, CHORD_SHIFT) == 3);
+    CHECK(FindKeyBinding(&t, 0x78, CHORD_CTRL) == 4);
+    CHECK(FindKeyBinding(&t, 0x78, CHORD_CTRL | CHORD_ALT) == 5);
+    CHECK(FindKeyBinding(&t, 0x79, 0) == -1);
+
+    // Ties go to the binding listed first
+    const char* twins[] = {"x1 toggle", "x1 hold"};
+    ConfigureBindings(twins, 2);
+    CompileTriggerTable(&t);
+    CHECK(FindButtonBinding(&t, TRIGGER_BUTTON_X1, 0) == 0);
+
+    // A chord released before its key still ends the gesture it started
+    const char* chord[] = {"f9", "ctrl+f9"};
+    ConfigureBindings(chord, 2);
+    CompileTriggerTable(&g_triggers);
+    g_activeBinding = 1;
+    CHECK(FindReleasedKeyBinding(&g_triggers, 0x78) == 1);
+    g_activeBinding = 0;
+    CHECK(FindReleasedKeyBinding(&g_triggers, 0x78) == 0);
+}
+
+// --- Held Buttons ---
+void TestHeldButtons()
+{
+    const char* specs[] = {"mbutton hold", "x1 hold"};
+    ConfigureBindings(specs, 2);
+    CompileTriggerTable(&g_triggers);
+    g_scrollState = STATE_IDLE;
+    HeldButtons held = {0, 0, 0};
+    int binding;
+
+    // A second bound button pressed mid-gesture must not take over the
+    // release that ends the hold gesture
+    PressHeldButton(&held, TRIGGER_BUTTON_MIDDLE, 0);
+    CHECK(OnTriggerButtonDown(0, 10, 10) == ACTION_NONE);
+    CHECK(BeginScrolling(50, 50));
+    PressHeldButton(&held, TRIGGER_BUTTON_X1, 1);
+    CHECK(OnTriggerButtonDown(1, 50, 50) == ACTION_NONE);
+    CHECK(held.button == TRIGGER_BUTTON_MIDDLE && held.binding == 0);
+    CHECK(ReleaseHeldButton(&held, TRIGGER_BUTTON_MIDDLE, &binding));
+    CHECK(binding == 0);
+    CHECK(OnTriggerButtonUp(binding) == ACTION_STOP);
+    CHECK(EndScrolling());
+    CHECK(ReleaseHeldButton(&held, TRIGGER_BUTTON_X1, &binding));
+    CHECK(binding == -1);
+    g_scrollState = STATE_IDLE;
+
+    // The hook can run ahead of the state machine: a press already held
+    // keeps the next one from being claimed even while still idle
+    PressHeldButton(&held, TRIGGER_BUTTON_MIDDLE, 0);
+    PressHeldButton(&held, TRIGGER_BUTTON_X1, 1);
+    CHECK(held.button == TRIGGER_BUTTON_MIDDLE);
+    CHECK(ReleaseHeldButton(&held, TRIGGER_BUTTON_X1, &binding));
+    CHECK(binding == -1);
+    CHECK(ReleaseHeldButton(&held, TRIGGER_BUTTON_MIDDLE, &binding));
+    CHECK(binding == 0);
+
+    // Stopping a toggle gesture: the click is swallowed as a pair
+    g_scrollState = STATE_SCROLLING;
+    PressHeldButton(&held, TRIGGER_BUTTON_X1, 1);
+    CHECK(held.button == 0 && held.swallowed == TRIGGER_BUTTON_X1);
+    CHECK(ReleaseHeldButton(&held, TRIGGER_BUTTON_X1, &binding));
+    CHECK(binding == -1 && held.swallowed == 0);
+
+    // Releases nobody swallowed are passed through
+    CHECK(!ReleaseHeldButton(&held, TRIGGER_BUTTON_RIGHT, &binding));
+    CHECK(!ReleaseHeldButton(&held, 0, &binding));
+    g_scrollState = STATE_IDLE;
+}
+
+// --- Entry Point ---
+int main()
+{
+    g_config.trace_file[0] = 0;
+    TestParse();
+    TestCompile();
+    TestLoadConfig();
+    TestFindBinding();
+    TestHeldButtons();
+    if (g_failures)
+    {
+        fprintf(stderr, "%d checks failed\n", g_failures);
+        return 1;
+    }
+    printf("trigger tests passed\n");
+    return 0;
+}